@@ -122,6 +122,8 @@ public:
   std::byte *base() const noexcept { return _storage.base(); }
   constexpr size_t size() const noexcept { return _storage.size(); }
   constexpr size_t max_size() const noexcept { return _storage.max_size(); }
+  // Blocks not handed out, O(1)
+  size_t available() const noexcept { return _count; }
   bool is_full() const noexcept { return _storage.is_full(_count); }
   bool is_empty() const noexcept { return _storage.is_empty(_head); }
 
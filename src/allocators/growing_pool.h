@@ -1,5 +1,6 @@
 #pragma once
 #include "ptr_utils.h"
+#include <array>
 #include <bit>
 #include <cassert>
 #include <cstddef>
@@ -67,19 +68,77 @@ private:
   upstream_t *_upstream;
   intrusive_slist<manager_node_ptr> _managers;
   smallest_t<max_managers> _manager_count{0};
+  // Manager nodes by id, so resolving a segmented pointer does not walk
+  // _managers (newest first). Grows with allocate_new_manager().
+  std::array<manager_node_ptr, max_managers> _directory{};
+  // Empty managers kept at the top of the id range once the blocks drain
+  size_t _retained_managers{1};
+
+  // Every segment is one upstream block, so an upstream that numbers its
+  // blocks lets pointer_type(void *) find (manager, segment) by block index
+  static constexpr bool keys_segments = provides_offset<upstream_t>;
+  using segment_key_type = typename pointer_type::segment_key_type;
+  std::array<segment_key_type, keys_segments ? upstream_t::max_block_count : 0>
+      _segment_keys{};
 
   using storage = segmented_ptr_storage<tag>;
   using alloc_cache = alloc_hint_cache<tag>;
   using lookup_cache = lookup_hint_cache<tag>;
 
 public:
+  // The manager chain as upstream offsets. Managers, their segments and all
+  // blocks live in upstream blocks, so with a file-backed upstream
+  // (mapped_buffer) this is all a restarted process needs to take the pool
+  // over again. Trivially copyable, to be stored in an upstream block.
+  struct checkpoint_type {
+    manager_node_ptr head{nullptr};
+    manager_node_ptr tail{nullptr};
+    smallest_t<max_managers> manager_count{0};
+  };
+
   explicit unique_growing_pool(upstream_t *upstream) : _upstream(upstream) {
     fatal(upstream == nullptr, "upstream allocator cannot be null");
     unwrap(storage::register_pool(this));
+    if constexpr (keys_segments) {
+      pointer_type::attach_segment_keys(
+          upstream->base(), std::countr_zero(upstream_t::block_size),
+          upstream_t::max_block_count, _segment_keys.data());
+    }
+  }
+
+  // Take over the managers handed out by release(), blocks allocated before
+  // stay valid and keep their segmented pointers
+  unique_growing_pool(upstream_t *upstream, const checkpoint_type &saved)
+      : unique_growing_pool(upstream) {
+    _managers = intrusive_slist<manager_node_ptr>(saved.head, saved.tail,
+                                                  saved.manager_count);
+    _manager_count = saved.manager_count;
+
+    size_t id = _manager_count;
+    for (auto it = _managers.begin(); it != _managers.end(); ++it) {
+      _directory[--id] = it.node();
+      publish_segments(id, it.node()->manager);
+    }
+  }
+
+  // Hand the managers out and leave the pool empty, so destroying it frees
+  // nothing and its blocks stay allocated in the upstream
+  checkpoint_type release() noexcept {
+    checkpoint_type saved{_managers.front(), _managers.back(), _manager_count};
+    _managers.clear();
+    _manager_count = 0;
+    _directory.fill(nullptr);
+    _segment_keys.fill(0);
+    pointer_type::clear_segment_bases();
+    alloc_cache::reset();
+    lookup_cache::reset();
+    return saved;
   }
 
   ~unique_growing_pool() override {
     storage::unregister_pool();
+    pointer_type::clear_segment_bases();
+    pointer_type::attach_segment_keys(nullptr, 0, 0, nullptr);
     alloc_cache::reset();
     lookup_cache::reset();
 
@@ -101,21 +160,21 @@ public:
     uint8_t cached_mgr = alloc_cache::get();
     if (cached_mgr < _manager_count) {
       auto manager = ok(get_manager_by_id(cached_mgr));
-      auto block_result = manager->try_allocate(_upstream);
+      auto block_result = manager->allocate_located(_upstream);
       if (block_result) {
         return encode_pointer(cached_mgr, manager, *block_result);
       }
     }
 
-    // Scan existing managers
-    size_t id = _manager_count;
-    for (auto &manager_node : _managers) {
-      --id;
+    // Scan the oldest managers first, so the newest ones drain and can be
+    // reclaimed
+    for (size_t id = 0; id < _manager_count; ++id) {
       if (id != cached_mgr) {
-        auto block_result = manager_node.manager.try_allocate(_upstream);
+        manager_type *manager = &_directory[id]->manager;
+        auto block_result = manager->allocate_located(_upstream);
         if (block_result) {
           alloc_cache::set(id);
-          return encode_pointer(id, &manager_node.manager, *block_result);
+          return encode_pointer(id, manager, *block_result);
         }
       }
     }
@@ -131,17 +190,38 @@ public:
 
     auto manager = ok(get_manager_by_id(manager_id));
 
+    size_t segment_id = ptr.get_segment_id();
+    std::byte *segment_base = ok(manager->get_segment_base(segment_id));
     auto *block = static_cast<block_type *>(static_cast<void *>(ptr));
-    ok(manager->deallocate(block, _upstream));
-    // TODO: deallocate empty managers to reclaim memory
+    ok(manager->deallocate(block, segment_id, _upstream));
+    // The last free block hands the segment back to the upstream
+    if (!manager->has_segment(segment_id)) {
+      retract_segment(segment_base);
+      if (manager->segment_count() == 0) {
+        reclaim_managers(_retained_managers);
+      }
+    }
 
     return {};
   }
 
+  // How many empty managers survive above the ones still holding blocks.
+  // Keeping one stops a workload that hovers at a manager boundary from
+  // freeing and recreating the manager on every block.
+  void set_retained_managers(size_t count) noexcept {
+    _retained_managers = count;
+    reclaim_managers(_retained_managers);
+  }
+
+  // Hand every empty manager above the highest one in use back to the
+  // upstream, returns how many were freed
+  size_t shrink_to_fit() noexcept { return reclaim_managers(0); }
+
   void reset() {
     for (auto manager : _managers) {
       manager.node()->manager.reset(_upstream);
     }
+    _segment_keys.fill(0);
     alloc_cache::reset();
     lookup_cache::reset();
   }
@@ -154,19 +234,14 @@ public:
     return total;
   }
 
+  // O(1) through the directory
   result<manager_type *> get_manager_by_id(size_t id) noexcept {
     fatal(id >= _manager_count, "ID greater than total count of managers");
-    size_t current_id = _manager_count - 1;
-
-    for (auto &manager_node : _managers) {
-      if (current_id == id) { return &manager_node.manager; }
-      if (current_id == 0) { break; }
-      --current_id;
-    }
-
-    return "manager for this ID not found";
+    return &_directory[id]->manager;
   }
 
+  size_t manager_count() const noexcept { return _manager_count; }
+
   result<size_t> find_manager_for_pointer(std::byte *ptr) const noexcept {
     auto *block = reinterpret_cast<block_type *>(ptr);
 
@@ -249,18 +324,76 @@ public:
   }
 
 private:
-  result<pointer_type> encode_pointer(size_t manager_id, manager_type *manager,
-                                      block_type *block) noexcept {
-    auto segment_id = ok(manager->find_segment_for_pointer(
-        reinterpret_cast<std::byte *>(block)));
+  result<pointer_type>
+  encode_pointer(size_t manager_id, manager_type *manager,
+                 typename manager_type::allocation allocation) noexcept {
+    size_t segment_id = allocation.segment_id;
     std::byte *segment_base = ok(manager->get_segment_base(segment_id));
-    auto byte_offset = reinterpret_cast<std::byte *>(block) - segment_base;
+    auto byte_offset =
+        reinterpret_cast<std::byte *>(allocation.block) - segment_base;
     fatal(byte_offset < 0, "block before segment base");
     size_t offset = byte_offset / block_size_v;
 
+    // The segment may be new, or have moved to another upstream block since
+    // its last pointer was handed out
+    publish_segment(manager_id, segment_id, segment_base);
     return pointer_type(manager_id, segment_id, offset);
   }
 
+  void publish_segment(size_t manager_id, size_t segment_id,
+                       std::byte *segment_base) noexcept {
+    pointer_type::set_segment_base(manager_id, segment_id, segment_base);
+    if constexpr (keys_segments) {
+      _segment_keys[upstream_index(segment_base)] =
+          pointer_type::segment_key(manager_id, segment_id);
+    }
+  }
+
+  void retract_segment(std::byte *segment_base) noexcept {
+    if constexpr (keys_segments) {
+      _segment_keys[upstream_index(segment_base)] = 0;
+    }
+  }
+
+  size_t upstream_index(std::byte *segment_base) const noexcept {
+    return static_cast<size_t>(segment_base - _upstream->base()) /
+           upstream_t::block_size;
+  }
+
+  void publish_segments(size_t manager_id,
+                        const manager_type &manager) noexcept {
+    for (size_t segment_id = 0; segment_id < manager_type::max_segments;
+         ++segment_id) {
+      if (manager.has_segment(segment_id)) {
+        std::byte *base = unwrap(manager.get_segment_base(segment_id));
+        publish_segment(manager_id, segment_id, base);
+      }
+    }
+  }
+
+  // Managers are only freed from the top of the id range, newest first, so
+  // the ids stay dense and every live segmented pointer keeps its manager.
+  // An empty manager below one in use waits until the ones above drain.
+  size_t reclaim_managers(size_t retained) noexcept {
+    size_t id = _manager_count;
+    while (id > 0 && _directory[id - 1]->manager.segment_count() == 0) {
+      --id;
+    }
+    size_t reclaimed = 0;
+    while (_manager_count > id + retained) {
+      manager_node_ptr curr = _managers.pop_front();
+      fatal(curr != _directory[_manager_count - 1],
+            "manager list out of id order");
+      _directory[--_manager_count] = nullptr;
+
+      curr->manager.~manager_type();
+      typename upstream_t::pointer_type upstream_ptr(static_cast<void *>(curr));
+      unwrap(_upstream->deallocate_block(upstream_ptr));
+      ++reclaimed;
+    }
+    return reclaimed;
+  }
+
   result<pointer_type> allocate_new_manager() noexcept {
     fail(_manager_count >= max_managers, "manager limit reached");
 
@@ -272,6 +405,7 @@ private:
     _managers.push_front(node_ptr_typed);
 
     size_t new_id = _manager_count++;
+    _directory[new_id] = node_ptr_typed;
     alloc_cache::set(new_id);
 
     return allocate_block();
@@ -300,5 +434,10 @@ private:
 #define growing_pool(block_size, manager_count, upstream_type)                 \
   unique_growing_pool<block_size, manager_count, upstream_type, decltype([] {})>
 
+// Same, but each thread constructs and registers its own pool of the one type
+#define per_thread_growing_pool(block_size, manager_count, upstream_type)      \
+  unique_growing_pool<block_size, manager_count, upstream_type,                \
+                      per_thread<decltype([] {})>>
+
 static_assert(is_homogenous<growing_pool(8, 32, local_buffer(16, 128))>,
               "growing_pool must implement homogenous concept");
@@ -1,6 +1,10 @@
+#include <array>
 #include <growing_pool.h>
 #include <gtest/gtest.h>
+#include <latch>
 #include <local_buffer.h>
+#include <memory>
+#include <thread>
 
 // ============================================================================
 // Test Fixture
@@ -123,6 +127,118 @@ TEST_F(GrowingPoolTest, MultipleManagerAllocation) {
   }
 }
 
+TEST_F(GrowingPoolTest, ManagerIdsResolveThroughDirectory) {
+  using manager_type = pool_type::manager_type;
+  constexpr size_t manager_capacity = manager_type::max_block_count;
+  constexpr size_t num_blocks = manager_capacity * 4;
+
+  std::array<pool_type::pointer_type, num_blocks> blocks;
+  for (size_t i = 0; i < num_blocks; ++i) {
+    blocks[i] = unwrap(pool.allocate_block());
+  }
+  EXPECT_EQ(pool.manager_count(), 4);
+
+  // Every pointer's manager id finds the manager that owns its block
+  for (auto block : blocks) {
+    auto *manager = unwrap(pool.get_manager_by_id(block.get_manager_id()));
+    EXPECT_TRUE(manager->owns(static_cast<pool_type::block_type *>(
+        static_cast<void *>(block))));
+  }
+
+  for (auto block : blocks) {
+    ASSERT_TRUE(pool.deallocate_block(block));
+  }
+}
+
+// ============================================================================
+// Manager Reclamation
+// ============================================================================
+
+TEST_F(GrowingPoolTest, DrainedManagersReturnToUpstream) {
+  constexpr size_t manager_capacity = pool_type::manager_type::max_block_count;
+  constexpr size_t num_blocks = manager_capacity * 4;
+  const size_t idle = upstream.available();
+
+  std::array<pool_type::pointer_type, num_blocks> blocks;
+  for (auto &block : blocks) {
+    block = unwrap(pool.allocate_block());
+  }
+  EXPECT_EQ(pool.manager_count(), 4);
+
+  for (auto block : blocks) {
+    ASSERT_TRUE(pool.deallocate_block(block));
+  }
+  // One empty manager is retained, the other three go back
+  EXPECT_EQ(pool.manager_count(), 1);
+  EXPECT_EQ(upstream.available(), idle - 1);
+
+  EXPECT_EQ(pool.shrink_to_fit(), 1);
+  EXPECT_EQ(pool.manager_count(), 0);
+  EXPECT_EQ(upstream.available(), idle);
+
+  auto block = unwrap(pool.allocate_block());
+  EXPECT_EQ(block.get_manager_id(), 0);
+  ASSERT_TRUE(pool.deallocate_block(block));
+}
+
+TEST_F(GrowingPoolTest, ReclaimingKeepsLiveManagerIds) {
+  constexpr size_t manager_capacity = pool_type::manager_type::max_block_count;
+  constexpr size_t num_blocks = manager_capacity * 4;
+
+  std::array<pool_type::pointer_type, num_blocks> blocks;
+  for (size_t i = 0; i < num_blocks; ++i) {
+    blocks[i] = unwrap(pool.allocate_block());
+    std::memset(static_cast<void *>(blocks[i]), static_cast<int>(i), 8);
+  }
+
+  // A block left in the newest manager pins the ones below it
+  for (size_t i = manager_capacity; i < num_blocks - 1; ++i) {
+    ASSERT_TRUE(pool.deallocate_block(blocks[i]));
+  }
+  EXPECT_EQ(pool.manager_count(), 4);
+
+  ASSERT_TRUE(pool.deallocate_block(blocks[num_blocks - 1]));
+  EXPECT_EQ(pool.manager_count(), 2);
+
+  // The oldest manager's blocks still resolve through their ids
+  for (size_t i = 0; i < manager_capacity; ++i) {
+    EXPECT_EQ(blocks[i].get_manager_id(), 0);
+    auto *bytes = static_cast<unsigned char *>(static_cast<void *>(blocks[i]));
+    EXPECT_EQ(bytes[0], static_cast<unsigned char>(i));
+    ASSERT_TRUE(pool.deallocate_block(blocks[i]));
+  }
+}
+
+TEST_F(GrowingPoolTest, RetainedManagerAbsorbsBoundaryChurn) {
+  constexpr size_t manager_capacity = pool_type::manager_type::max_block_count;
+
+  std::array<pool_type::pointer_type, manager_capacity> full;
+  for (auto &block : full) {
+    block = unwrap(pool.allocate_block());
+  }
+
+  // Every cycle crosses into a second manager and drains it again
+  auto first = unwrap(pool.allocate_block());
+  ASSERT_TRUE(pool.deallocate_block(first));
+  const size_t settled = upstream.available();
+  for (int cycle = 0; cycle < 100; ++cycle) {
+    auto block = unwrap(pool.allocate_block());
+    EXPECT_EQ(block.get_manager_id(), 1);
+    ASSERT_TRUE(pool.deallocate_block(block));
+    EXPECT_EQ(pool.manager_count(), 2);
+  }
+  EXPECT_EQ(upstream.available(), settled);
+
+  pool.set_retained_managers(0);
+  EXPECT_EQ(pool.manager_count(), 1);
+  EXPECT_EQ(upstream.available(), settled + 1);
+
+  for (auto block : full) {
+    ASSERT_TRUE(pool.deallocate_block(block));
+  }
+  EXPECT_EQ(pool.manager_count(), 0);
+}
+
 // ============================================================================
 // Integration Tests
 // ============================================================================
@@ -179,3 +295,46 @@ TEST_F(GrowingPoolTest, MultiplePools) {
 
   ASSERT_TRUE(pool1.deallocate_block(ptr1));
 }
+
+// ============================================================================
+// Per-Thread Context
+// ============================================================================
+
+TEST(PerThreadGrowingPoolTest, EachThreadRegistersItsOwnPool) {
+  using thread_upstream = per_thread_local_buffer(16, 128);
+  using thread_pool = per_thread_growing_pool(8, 32, thread_upstream);
+
+  constexpr int threads = 2;
+  std::latch constructed(threads);
+  std::array<bool, threads> round_trips{};
+
+  auto run = [&](int i) {
+    // A second pool of one type would fail to register with a per-type
+    // context
+    auto upstream = std::make_unique<thread_upstream>();
+    auto pool = std::make_unique<thread_pool>(upstream.get());
+    constructed.arrive_and_wait();
+
+    bool ok = true;
+    std::array<thread_pool::pointer_type, 16> blocks;
+    for (size_t n = 0; n < blocks.size(); ++n) {
+      blocks[n] = *pool->allocate_block();
+      auto *value = static_cast<uint64_t *>(static_cast<void *>(blocks[n]));
+      *value = i * 1000 + n;
+    }
+    for (size_t n = 0; n < blocks.size(); ++n) {
+      auto *value = static_cast<uint64_t *>(static_cast<void *>(blocks[n]));
+      ok = ok && *value == i * 1000 + n;
+      ok = ok && pool->deallocate_block(blocks[n]).has_value();
+    }
+    round_trips[i] = ok;
+  };
+
+  std::thread a(run, 0);
+  std::thread b(run, 1);
+  a.join();
+  b.join();
+
+  EXPECT_TRUE(round_trips[0]);
+  EXPECT_TRUE(round_trips[1]);
+}
@@ -62,6 +62,7 @@ public:
 
   void reset() { _list.reset(); }
   std::size_t size() const noexcept { return _list.size(); };
+  std::size_t available() const noexcept { return _list.available(); }
   std::byte *base() const noexcept { return _list.base(); }
 
   unique_local_buffer() { pointer_type::set_base(base()); }
@@ -125,6 +126,10 @@ std::pmr::memory_resource
 #define local_buffer(block_size, block_count)                                  \
   unique_local_buffer<block_size, block_count, decltype([] {})>
 
+// Same, but each thread constructs its own buffer of the one type
+#define per_thread_local_buffer(block_size, block_count)                       \
+  unique_local_buffer<block_size, block_count, per_thread<decltype([] {})>>
+
 static_assert(is_homogenous<local_buffer(256, 8)>,
               "local_buffer must implement homogeneous_allocator concept");
 static_assert(provides_offset<local_buffer(256, 8)>,
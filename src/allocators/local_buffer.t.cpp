@@ -1,6 +1,9 @@
 #include <array>
 #include <gtest/gtest.h>
+#include <latch>
 #include <local_buffer.h>
+#include <memory>
+#include <thread>
 
 constexpr size_t block_size{64};
 constexpr size_t block_count{4};
@@ -33,6 +36,16 @@ TEST_F(LocalBufferTest, CanReset) {
   buffer.reset();
 }
 
+TEST_F(LocalBufferTest, AvailableCountsFreeBlocks) {
+  EXPECT_EQ(buffer.available(), block_count);
+
+  auto ptr = unwrap(buffer.allocate_block());
+  EXPECT_EQ(buffer.available(), block_count - 1);
+
+  buffer.deallocate_block(ptr);
+  EXPECT_EQ(buffer.available(), block_count);
+}
+
 TEST_F(LocalBufferTest, ConsecutiveAllocationsReturnDistinctBlocks) {
   std::array<test_buffer::pointer_type, 3> ptrs{};
 
@@ -134,3 +147,38 @@ TEST_F(LocalBufferTest, DeallocateNullPtrReturnsError) {
   EXPECT_FALSE(dealloc_result.has_value());
   EXPECT_EQ(dealloc_result.error(), error::generic);
 }
+
+// ============================================================================
+// Per-Thread Context
+// ============================================================================
+
+TEST(PerThreadLocalBufferTest, EachThreadResolvesIntoItsOwnBuffer) {
+  using thread_buffer = per_thread_local_buffer(block_size, block_count);
+  static_assert(per_thread_allocator<thread_buffer>);
+
+  constexpr int threads = 2;
+  std::latch constructed(threads);
+  std::array<std::byte *, threads> bases{};
+  std::array<bool, threads> owned{};
+
+  auto run = [&](int i) {
+    auto buffer = std::make_unique<thread_buffer>();
+    bases[i] = buffer->base();
+    // Both buffers exist before either thread resolves a pointer
+    constructed.arrive_and_wait();
+
+    auto block = *buffer->allocate_block();
+    auto *raw = static_cast<std::byte *>(static_cast<void *>(block));
+    owned[i] = raw >= bases[i] && raw < bases[i] + thread_buffer::total_size;
+    buffer->deallocate_block(block);
+  };
+
+  std::thread a(run, 0);
+  std::thread b(run, 1);
+  a.join();
+  b.join();
+
+  EXPECT_NE(bases[0], bases[1]);
+  EXPECT_TRUE(owned[0]);
+  EXPECT_TRUE(owned[1]);
+}
@@ -0,0 +1,233 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <freelist.h>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <pointers/thin_ptr.h>
+#include <result/result.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <types.h>
+#include <unistd.h>
+
+// local_buffer whose freelist and blocks live in a memory-mapped file (POSIX).
+// The freelist links blocks by index and everything built on top of it links
+// by offset (thin pointers from the base, segmented pointers through the
+// managers), so the file is position-independent: reopening it maps the
+// arena back exactly as it was left and only the thin_ptr base is
+// re-registered. Nothing is replayed.
+//
+// The file header holds root_count root slots, block pointers that survive
+// restarts, so a program can find its queue objects and growing_pool
+// checkpoints again.
+template <size_t block_size_t, size_t block_count_t, typename tag>
+  requires nonzero_power_of_two<block_size_t, block_count_t>
+class unique_mapped_buffer : public std::pmr::memory_resource {
+public:
+  static constexpr size_t block_size = block_size_t;
+  static constexpr size_t block_align = block_size_t;
+  static constexpr size_t max_block_count = block_count_t;
+  static constexpr size_t total_size = block_size_t * block_count_t;
+  static constexpr size_t root_count = 16;
+
+  static constexpr uint32_t file_magic = 0x4250414d; // "MAPB"
+  static constexpr uint16_t file_version = 1;
+
+private:
+  using freelist_type = freelist<block_size, block_count_t, tag>;
+
+public:
+  using unique_tag = tag;
+  using block_type = freelist_type::block_type;
+  using offset_type = freelist_type::offset_type;
+  using pointer_type = basic_thin_ptr<block_type, block_type, offset_type, tag>;
+
+private:
+  // magic is written last when formatting, so a file whose creation was
+  // interrupted still reads as unformatted
+  struct file_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t root_count;
+    uint64_t block_size;
+    uint64_t block_count;
+    std::array<offset_type, root_count> roots;
+  };
+
+  // mmap only guarantees page alignment
+  static_assert(alignof(freelist_type) <= 4096,
+                "mapped_buffer block_size must not exceed the page size");
+
+  static constexpr size_t list_offset =
+      (sizeof(file_header) + alignof(freelist_type) - 1) /
+      alignof(freelist_type) * alignof(freelist_type);
+
+public:
+  static constexpr size_t file_size = list_offset + sizeof(freelist_type);
+
+private:
+  std::byte *_mapping;
+  freelist_type *_list;
+  bool _recovered;
+  std::function<void()> _on_oom_callback{nullptr};
+
+  unique_mapped_buffer(std::byte *mapping, bool recovered) noexcept
+      : _mapping(mapping), _recovered(recovered) {
+    if (recovered) {
+      _list = std::launder(
+          reinterpret_cast<freelist_type *>(mapping + list_offset));
+    } else {
+      _list = new (mapping + list_offset) freelist_type();
+      file_header *header = new (mapping) file_header{};
+      header->version = file_version;
+      header->root_count = root_count;
+      header->block_size = block_size;
+      header->block_count = block_count_t;
+      header->roots.fill(std::numeric_limits<offset_type>::max());
+      std::atomic_signal_fence(std::memory_order_release);
+      header->magic = file_magic;
+    }
+    pointer_type::set_base(base());
+  }
+
+  file_header *header() const noexcept {
+    return std::launder(reinterpret_cast<file_header *>(_mapping));
+  }
+
+public:
+  // Map the file at path, creating and formatting it if it is new. A file
+  // written for another block size or count is rejected.
+  static result<std::unique_ptr<unique_mapped_buffer>>
+  open(const char *path) noexcept {
+    int fd = ::open(path, O_RDWR | O_CREAT, 0600);
+    fail(fd < 0, "cannot open mapped_buffer file");
+
+    struct stat info{};
+    bool sized = ::fstat(fd, &info) == 0;
+    if (sized && info.st_size == 0) {
+      sized = ::ftruncate(fd, file_size) == 0;
+    } else if (sized) {
+      sized = static_cast<size_t>(info.st_size) == file_size;
+    }
+
+    void *mapping = MAP_FAILED;
+    if (sized) {
+      mapping = ::mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd, 0);
+    }
+    ::close(fd);
+    fail(!sized, "mapped_buffer file has the wrong size");
+    fail(mapping == MAP_FAILED, "cannot map mapped_buffer file");
+
+    auto *bytes = static_cast<std::byte *>(mapping);
+    auto *existing = std::launder(reinterpret_cast<file_header *>(bytes));
+    bool recovered = existing->magic == file_magic;
+    bool compatible = existing->magic == 0 ||
+                      (recovered && existing->version == file_version &&
+                       existing->root_count == root_count &&
+                       existing->block_size == block_size &&
+                       existing->block_count == block_count_t);
+    if (!compatible) { ::munmap(mapping, file_size); }
+    fail(!compatible, "mapped_buffer file was written for another layout");
+
+    return std::unique_ptr<unique_mapped_buffer>(
+        new unique_mapped_buffer(bytes, recovered));
+  }
+
+  // Blocks stay in the file, only the mapping goes away
+  ~unique_mapped_buffer() override {
+    pointer_type::set_base(nullptr);
+    ::munmap(_mapping, file_size);
+  }
+
+  unique_mapped_buffer(const unique_mapped_buffer &) = delete;
+  unique_mapped_buffer &operator=(const unique_mapped_buffer &) = delete;
+
+  // Whether open() found an existing arena rather than formatting a new one
+  bool recovered() const noexcept { return _recovered; }
+
+  // Write dirty pages back to the file, surviving a system crash as well
+  result<> flush() noexcept {
+    fail(::msync(_mapping, file_size, MS_SYNC) != 0, "msync failed");
+    return {};
+  }
+
+  pointer_type root(size_t slot) const noexcept {
+    fatal(slot >= root_count, "root slot out of range");
+    return pointer_type::from_offset(header()->roots[slot]);
+  }
+
+  void set_root(size_t slot, pointer_type block) noexcept {
+    fatal(slot >= root_count, "root slot out of range");
+    header()->roots[slot] = block.offset();
+  }
+
+  result<pointer_type> allocate_block() {
+    auto result = _list->pop();
+    if (!result.has_value()) {
+      if (_on_oom_callback) {
+        _on_oom_callback();
+        std::unreachable();
+      }
+      return result.error();
+    }
+    return pointer_type(&result.value());
+  }
+
+  result<> deallocate_block(pointer_type ptr) {
+    fail(ptr == nullptr);
+
+    void *raw = static_cast<void *>(ptr);
+    ok(_list->push(*static_cast<block_type *>(raw)));
+    return {};
+  }
+
+  void reset() { _list->reset(); }
+  std::size_t size() const noexcept { return _list->size(); };
+  std::size_t available() const noexcept { return _list->available(); }
+  std::byte *base() const noexcept { return _list->base(); }
+
+  void set_oom_callback(std::function<void()> callback) noexcept {
+    _on_oom_callback = callback;
+  }
+
+private:
+  void *do_allocate(size_t size, size_t alignment) override {
+    fatal(size == 0);
+    fatal(alignment == 0);
+    fatal(alignment > size, "alignment cannot exceed size");
+
+    if (size > block_size || alignment > block_size) { return nullptr; }
+    return to_nullptr(allocate_block());
+  }
+
+  void do_deallocate(void *ptr, size_t size, size_t alignment) override {
+    fatal(ptr == nullptr);
+    fatal(size == 0);
+    fatal(alignment == 0);
+    fatal(alignment > size, "alignment cannot exceed size");
+
+    if (size > block_size || alignment > block_size) { return; }
+    deallocate_block(ptr);
+  }
+
+  bool
+  do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+
+#define mapped_buffer(block_size, block_count)                                 \
+  unique_mapped_buffer<block_size, block_count, decltype([] {})>
+
+static_assert(is_homogenous<mapped_buffer(256, 8)>,
+              "mapped_buffer must implement homogeneous_allocator concept");
+static_assert(provides_offset<mapped_buffer(256, 8)>,
+              "mapped_buffer must provide offset-based addressing");
@@ -0,0 +1,123 @@
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <growing_pool.h>
+#include <gtest/gtest.h>
+#include <mapped_buffer.h>
+#include <memory>
+#include <new>
+#include <string>
+
+using test_mapped = mapped_buffer(64, 128);
+
+class MappedBufferTest : public ::testing::Test {
+protected:
+  std::string path;
+
+  void SetUp() override {
+    path = ::testing::TempDir() + "mapped_buffer_" +
+           ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    std::remove(path.c_str());
+  }
+
+  void TearDown() override { std::remove(path.c_str()); }
+};
+
+static uint64_t &word(auto block) {
+  return *static_cast<uint64_t *>(static_cast<void *>(block));
+}
+
+TEST_F(MappedBufferTest, NewFileIsFormatted) {
+  auto opened = test_mapped::open(path.c_str());
+  ASSERT_TRUE(opened.has_value());
+  auto &buffer = *opened;
+
+  EXPECT_FALSE(buffer->recovered());
+  EXPECT_EQ(buffer->size(), test_mapped::max_block_count);
+  EXPECT_EQ(buffer->root(0), nullptr);
+  EXPECT_TRUE(buffer->allocate_block().has_value());
+}
+
+TEST_F(MappedBufferTest, ReopenRecoversBlocksAndRoots) {
+  {
+    auto opened = test_mapped::open(path.c_str());
+    ASSERT_TRUE(opened.has_value());
+    auto block = *(*opened)->allocate_block();
+    word(block) = 0xfeedface;
+    (*opened)->set_root(3, block);
+  }
+
+  auto reopened = test_mapped::open(path.c_str());
+  ASSERT_TRUE(reopened.has_value());
+  auto &buffer = *reopened;
+  EXPECT_TRUE(buffer->recovered());
+
+  auto block = buffer->root(3);
+  ASSERT_NE(block, nullptr);
+  EXPECT_EQ(word(block), 0xfeedface);
+
+  // The recovered freelist doesn't hand the rooted block out again
+  for (size_t i = 1; i < test_mapped::max_block_count; ++i) {
+    auto other = buffer->allocate_block();
+    ASSERT_TRUE(other.has_value());
+    EXPECT_NE(*other, block);
+  }
+}
+
+TEST_F(MappedBufferTest, RejectsFileOfOtherLayout) {
+  using other_mapped = mapped_buffer(64, 64);
+  ASSERT_TRUE(test_mapped::open(path.c_str()).has_value());
+  EXPECT_FALSE(other_mapped::open(path.c_str()).has_value());
+
+  // The original layout still opens
+  auto reopened = test_mapped::open(path.c_str());
+  ASSERT_TRUE(reopened.has_value());
+  EXPECT_TRUE((*reopened)->recovered());
+}
+
+// ============================================================================
+// growing_pool on a Mapped Upstream
+// ============================================================================
+
+using pool_upstream = mapped_buffer(64, 128);
+using recovered_pool = growing_pool(8, 8, pool_upstream);
+
+struct pool_root {
+  recovered_pool::checkpoint_type pool;
+  std::array<recovered_pool::pointer_type, 4> blocks;
+};
+static_assert(sizeof(pool_root) <= pool_upstream::block_size);
+
+TEST_F(MappedBufferTest, GrowingPoolRecoversFromCheckpoint) {
+  {
+    auto opened = pool_upstream::open(path.c_str());
+    ASSERT_TRUE(opened.has_value());
+    auto &upstream = *opened;
+    auto pool = std::make_unique<recovered_pool>(upstream.get());
+
+    auto root_block = *upstream->allocate_block();
+    auto *root = new (static_cast<void *>(root_block)) pool_root{};
+    for (size_t i = 0; i < root->blocks.size(); ++i) {
+      root->blocks[i] = *pool->allocate_block();
+      word(root->blocks[i]) = i * 11;
+    }
+    root->pool = pool->release();
+    upstream->set_root(0, root_block);
+  }
+
+  auto reopened = pool_upstream::open(path.c_str());
+  ASSERT_TRUE(reopened.has_value());
+  auto &upstream = *reopened;
+  ASSERT_TRUE(upstream->recovered());
+
+  auto *root = std::launder(
+      static_cast<pool_root *>(static_cast<void *>(upstream->root(0))));
+  recovered_pool pool(upstream.get(), root->pool);
+  for (size_t i = 0; i < root->blocks.size(); ++i) {
+    EXPECT_EQ(word(root->blocks[i]), i * 11);
+    EXPECT_TRUE(pool.deallocate_block(root->blocks[i]).has_value());
+  }
+
+  // The adopted managers keep serving allocations
+  EXPECT_TRUE(pool.allocate_block().has_value());
+}
@@ -0,0 +1,156 @@
+#include <benchmark/benchmark.h>
+#include <growing_pool.h>
+#include <local_buffer.h>
+#include <memory>
+#include <vector>
+
+// ============================================================================
+// Pointer Resolution - Per-Type vs Per-Thread Context
+// ============================================================================
+// Resolves a set of allocated blocks once per iteration. The per_thread
+// variants read the base address or the registered pool from thread-local
+// storage instead of a plain static.
+// ============================================================================
+
+using static_buffer = local_buffer(64, 1024);
+using thread_buffer = per_thread_local_buffer(64, 1024);
+
+template <typename buffer_type>
+static void BM_ThinPtrResolve(benchmark::State &state) {
+  auto buffer = std::make_unique<buffer_type>();
+  std::vector<typename buffer_type::pointer_type> blocks;
+  for (size_t i = 0; i < buffer_type::max_block_count; ++i) {
+    blocks.push_back(*buffer->allocate_block());
+  }
+
+  for (auto _ : state) {
+    for (auto block : blocks) {
+      benchmark::DoNotOptimize(static_cast<void *>(block));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * blocks.size());
+}
+BENCHMARK_TEMPLATE(BM_ThinPtrResolve, static_buffer);
+BENCHMARK_TEMPLATE(BM_ThinPtrResolve, thread_buffer);
+
+using static_upstream = local_buffer(16, 128);
+using static_pool = growing_pool(8, 32, static_upstream);
+using thread_upstream = per_thread_local_buffer(16, 128);
+using thread_pool = per_thread_growing_pool(8, 32, thread_upstream);
+
+template <typename upstream_type, typename pool_type>
+static void BM_SegmentedPtrResolve(benchmark::State &state) {
+  auto upstream = std::make_unique<upstream_type>();
+  auto pool = std::make_unique<pool_type>(upstream.get());
+  std::vector<typename pool_type::pointer_type> blocks;
+  for (int i = 0; i < 64; ++i) {
+    blocks.push_back(*pool->allocate_block());
+  }
+
+  for (auto _ : state) {
+    for (auto block : blocks) {
+      benchmark::DoNotOptimize(static_cast<void *>(block));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * blocks.size());
+
+  for (auto block : blocks) {
+    pool->deallocate_block(block);
+  }
+}
+BENCHMARK_TEMPLATE(BM_SegmentedPtrResolve, static_upstream, static_pool);
+BENCHMARK_TEMPLATE(BM_SegmentedPtrResolve, thread_upstream, thread_pool);
+
+// Baseline for BM_SegmentedPtrResolve: the same blocks through raw pointers.
+// Release builds resolve segmented pointers from the segment base table,
+// debug builds through the pool's checked, virtual path.
+static void BM_RawPtrResolve(benchmark::State &state) {
+  auto upstream = std::make_unique<static_upstream>();
+  auto pool = std::make_unique<static_pool>(upstream.get());
+  std::vector<static_pool::pointer_type> blocks;
+  std::vector<void *> raw;
+  for (int i = 0; i < 64; ++i) {
+    blocks.push_back(*pool->allocate_block());
+    raw.push_back(static_cast<void *>(blocks.back()));
+  }
+
+  for (auto _ : state) {
+    for (void *block : raw) {
+      benchmark::DoNotOptimize(block);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * raw.size());
+
+  for (auto block : blocks) {
+    pool->deallocate_block(block);
+  }
+}
+BENCHMARK(BM_RawPtrResolve);
+
+// ============================================================================
+// Pointer Resolution - Manager Count
+// ============================================================================
+// Fills the given number of managers and resolves every block once per
+// iteration. Each resolve looks its manager up by id, so the cost per item
+// should not grow with the manager count.
+// ============================================================================
+
+using scaled_upstream = local_buffer(16, 512);
+using scaled_pool = growing_pool(8, 32, scaled_upstream);
+
+static void BM_SegmentedPtrResolveManagers(benchmark::State &state) {
+  auto upstream = std::make_unique<scaled_upstream>();
+  auto pool = std::make_unique<scaled_pool>(upstream.get());
+  std::vector<scaled_pool::pointer_type> blocks;
+  size_t block_count =
+      state.range(0) * scaled_pool::manager_type::max_block_count;
+  for (size_t i = 0; i < block_count; ++i) {
+    blocks.push_back(*pool->allocate_block());
+  }
+
+  for (auto _ : state) {
+    for (auto block : blocks) {
+      benchmark::DoNotOptimize(static_cast<void *>(block));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * blocks.size());
+  state.counters["managers"] = static_cast<double>(pool->manager_count());
+
+  for (auto block : blocks) {
+    pool->deallocate_block(block);
+  }
+}
+BENCHMARK(BM_SegmentedPtrResolveManagers)->RangeMultiplier(2)->Range(1, 32);
+
+// ============================================================================
+// Raw to Segmented Conversion
+// ============================================================================
+// Converts raw block addresses back to segmented pointers, as offset_list
+// and intrusive_slist do for every new node. The pool's reverse map over
+// the upstream blocks makes this independent of the manager count.
+// ============================================================================
+
+static void BM_SegmentedPtrFromRaw(benchmark::State &state) {
+  auto upstream = std::make_unique<scaled_upstream>();
+  auto pool = std::make_unique<scaled_pool>(upstream.get());
+  std::vector<scaled_pool::pointer_type> blocks;
+  std::vector<void *> raw;
+  size_t block_count =
+      state.range(0) * scaled_pool::manager_type::max_block_count;
+  for (size_t i = 0; i < block_count; ++i) {
+    blocks.push_back(*pool->allocate_block());
+    raw.push_back(static_cast<void *>(blocks.back()));
+  }
+
+  for (auto _ : state) {
+    for (void *block : raw) {
+      benchmark::DoNotOptimize(scaled_pool::pointer_type(block));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * raw.size());
+
+  for (auto block : blocks) {
+    pool->deallocate_block(block);
+  }
+}
+BENCHMARK(BM_SegmentedPtrFromRaw)->RangeMultiplier(2)->Range(1, 32);
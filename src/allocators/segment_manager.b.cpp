@@ -0,0 +1,63 @@
+#include <benchmark/benchmark.h>
+#include <local_buffer.h>
+#include <memory>
+#include <segment_manager.h>
+#include <vector>
+
+// ============================================================================
+// Segment Selection
+// ============================================================================
+// Fills every segment but the last one, then allocates and frees a block in
+// a loop. Finding the one segment with free blocks is a bitmap search, so
+// the cost should not grow with the number of full segments in front of it.
+// ============================================================================
+
+// 4 segments of 2 blocks
+using small_upstream = local_buffer(16, 128);
+using small_manager = segment_manager<8, small_upstream>;
+// 72 segments of 32 blocks
+using large_upstream = local_buffer(256, 128);
+using large_manager = segment_manager<8, large_upstream>;
+
+template <typename upstream_type, typename manager_type>
+static void BM_SegmentManagerAllocate(benchmark::State &state) {
+  auto upstream = std::make_unique<upstream_type>();
+  auto manager = std::make_unique<manager_type>();
+  std::vector<typename manager_type::block_type *> blocks;
+  for (size_t i = 0; i < manager_type::max_block_count - 1; ++i) {
+    blocks.push_back(*manager->try_allocate(upstream.get()));
+  }
+
+  for (auto _ : state) {
+    auto allocation = *manager->allocate_located(upstream.get());
+    benchmark::DoNotOptimize(allocation.block);
+    manager->deallocate(allocation.block, allocation.segment_id,
+                        upstream.get());
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["segments"] = manager_type::max_segments;
+
+  manager->cleanup(upstream.get());
+}
+BENCHMARK_TEMPLATE(BM_SegmentManagerAllocate, small_upstream, small_manager);
+BENCHMARK_TEMPLATE(BM_SegmentManagerAllocate, large_upstream, large_manager);
+
+template <typename upstream_type, typename manager_type>
+static void BM_SegmentManagerCapacity(benchmark::State &state) {
+  auto upstream = std::make_unique<upstream_type>();
+  auto manager = std::make_unique<manager_type>();
+  for (size_t i = 0; i < manager_type::max_block_count; ++i) {
+    benchmark::DoNotOptimize(*manager->try_allocate(upstream.get()));
+  }
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager->has_capacity());
+    benchmark::DoNotOptimize(manager->is_empty());
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["segments"] = manager_type::max_segments;
+
+  manager->cleanup(upstream.get());
+}
+BENCHMARK_TEMPLATE(BM_SegmentManagerCapacity, small_upstream, small_manager);
+BENCHMARK_TEMPLATE(BM_SegmentManagerCapacity, large_upstream, large_manager);
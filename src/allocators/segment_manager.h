@@ -1,11 +1,91 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <freelist.h>
+#include <limits>
 #include <result/result.h>
+#include <type_traits>
 #include <types.h>
 
+// Bytes of one bitmap word for bits entries: a single word up to 64 bits
+constexpr size_t bitmap_word_bytes(size_t bits) noexcept {
+  return bits <= 8 ? 1 : bits <= 16 ? 2 : bits <= 32 ? 4 : 8;
+}
+
+// Fixed-size bitset over segment slots. Searches take countr_zero per word,
+// so with up to 64 slots every query is a single word operation.
+template <size_t bits> class segment_bitmap {
+public:
+  using word_type = std::conditional_t<
+      bitmap_word_bytes(bits) == 1, uint8_t,
+      std::conditional_t<
+          bitmap_word_bytes(bits) == 2, uint16_t,
+          std::conditional_t<bitmap_word_bytes(bits) == 4, uint32_t,
+                             uint64_t>>>;
+  static constexpr size_t word_bits = std::numeric_limits<word_type>::digits;
+  static constexpr size_t word_count = (bits + word_bits - 1) / word_bits;
+
+private:
+  std::array<word_type, word_count> _words{};
+
+  static constexpr word_type bit(size_t i) noexcept {
+    return static_cast<word_type>(word_type{1} << (i % word_bits));
+  }
+
+public:
+  bool test(size_t i) const noexcept {
+    return (_words[i / word_bits] & bit(i)) != 0;
+  }
+  void set(size_t i) noexcept { _words[i / word_bits] |= bit(i); }
+  void reset(size_t i) noexcept {
+    _words[i / word_bits] &= static_cast<word_type>(~bit(i));
+  }
+  void clear() noexcept { _words.fill(0); }
+
+  bool none() const noexcept {
+    return std::ranges::all_of(_words, [](word_type w) { return w == 0; });
+  }
+
+  size_t count() const noexcept {
+    size_t total = 0;
+    for (word_type word : _words) {
+      total += std::popcount(word);
+    }
+    return total;
+  }
+
+  // First set bit at or after from, bits if there is none
+  size_t next(size_t from) const noexcept {
+    for (size_t w = from / word_bits; w < word_count; ++w) {
+      word_type word = _words[w];
+      if (w == from / word_bits) {
+        word &= static_cast<word_type>(std::numeric_limits<word_type>::max()
+                                       << (from % word_bits));
+      }
+      if (word != 0) { return w * word_bits + std::countr_zero(word); }
+    }
+    return bits;
+  }
+
+  size_t first() const noexcept { return next(0); }
+
+  // First clear bit, bits if all are set
+  size_t first_clear() const noexcept {
+    for (size_t w = 0; w < word_count; ++w) {
+      auto word = static_cast<word_type>(~_words[w]);
+      if (word != 0) {
+        return std::min(w * word_bits + std::countr_zero(word), bits);
+      }
+    }
+    return bits;
+  }
+};
+
 // Non-unique, reusable component that manages a fixed number of segments.
 template <size_t block_size_v, is_homogenous upstream_t>
   requires is_power_of_two<block_size_v>
@@ -75,43 +155,76 @@ private:
 public:
   static constexpr size_t block_size = block_size_v;
   static constexpr size_t block_align = block_size_v;
-  // reserve for high_water_mark(1) + next pointer (1-2) + padding (0)
-  static constexpr size_t reserve = 4;
-  static constexpr size_t max_segments =
-      (upstream_t::block_size - reserve) / sizeof(segment_metadata);
+
+private:
+  using upstream_pointer = typename upstream_t::pointer_type;
+
+  static constexpr size_t round_up(size_t value, size_t align) noexcept {
+    return (value + align - 1) / align * align;
+  }
+
+  // Bytes of growing_pool's manager node for n segments: the two bitmaps and
+  // the metadata, followed by the node's upstream next pointer
+  static constexpr size_t node_bytes(size_t n) noexcept {
+    size_t word = bitmap_word_bytes(n);
+    size_t bitmap = word * ((n + word * 8 - 1) / (word * 8));
+    size_t manager_align = std::max(alignof(segment_metadata), word);
+    size_t manager =
+        round_up(round_up(2 * bitmap, alignof(segment_metadata)) +
+                     n * sizeof(segment_metadata),
+                 manager_align);
+    return round_up(round_up(manager, alignof(upstream_pointer)) +
+                        sizeof(upstream_pointer),
+                    std::max(manager_align, alignof(upstream_pointer)));
+  }
+
+  static constexpr size_t fit_segments() noexcept {
+    size_t n = upstream_t::block_size / sizeof(segment_metadata);
+    while (n > 0 && node_bytes(n) > upstream_t::block_size) {
+      --n;
+    }
+    return n;
+  }
+
+public:
+  // As many segments as fit one upstream block next to growing_pool's
+  // next pointer
+  static constexpr size_t max_segments = fit_segments();
   static_assert(max_segments > 0,
                 "Upstream block size too small for segment_manager");
   static constexpr size_t max_block_count = blocks_per_segment * max_segments;
   static constexpr size_t total_size_v = block_size * max_block_count;
 
-  // segment count, never decreased (one past the last valid index)
-  smallest_t<max_segments> _high_water_mark{0};
+  // Slots holding a segment, and the subset of those with free blocks
+  segment_bitmap<max_segments> _valid{};
+  segment_bitmap<max_segments> _available{};
   std::array<segment_metadata, max_segments> _segments{};
 
   segment_manager() = default;
   ~segment_manager() = default;
 
   void cleanup(upstream_t *upstream) noexcept {
-    for (auto &segment : std::span(_segments.data(), _high_water_mark)) {
-      if (segment.is_valid()) {
-        unwrap(upstream->deallocate_block(segment.segment_ptr));
-        segment.segment_ptr = nullptr; // Mark as invalid to prevent double-free
-      }
+    for (size_t i = _valid.first(); i < max_segments; i = _valid.next(i + 1)) {
+      auto &segment = _segments[i];
+      unwrap(upstream->deallocate_block(segment.segment_ptr));
+      segment.segment_ptr = nullptr; // Mark as invalid to prevent double-free
     }
+    _valid.clear();
+    _available.clear();
   }
 
   // Reset all segments to initial state
   void reset(upstream_t *upstream) noexcept {
     cleanup(upstream);
-    _high_water_mark = 0;
     _segments = {};
   }
 
-  // Count total available blocks across all segments
+  // Count total available blocks, visiting only segments that have some
   size_t available_count() const noexcept {
     size_t total = 0;
-    for (size_t i = 0; i < _high_water_mark; ++i) {
-      if (_segments[i].is_valid()) { total += _segments[i].freelist_count; }
+    for (size_t i = _available.first(); i < max_segments;
+         i = _available.next(i + 1)) {
+      total += _segments[i].freelist_count;
     }
     return total;
   }
@@ -121,12 +234,25 @@ public:
   segment_manager(segment_manager &&) = delete;
   segment_manager &operator=(segment_manager &&) = delete;
 
-  result<block_type *> try_allocate(upstream_t *upstream) noexcept {
-    for (size_t i = 0; i < _high_water_mark; ++i) {
-      if (auto *block = _segments[i].try_allocate()) { return block; }
-    }
+  // A block together with the segment it was taken from
+  struct allocation {
+    block_type *block;
+    size_t segment_id;
+  };
 
-    return allocate_new_segment(upstream);
+  // Like try_allocate(), but also reports the segment, so growing_pool can
+  // encode a pointer without searching for it
+  result<allocation> allocate_located(upstream_t *upstream) noexcept {
+    size_t i = _available.first();
+    if (i == max_segments) { return allocate_new_segment(upstream); }
+
+    auto *block = _segments[i].try_allocate();
+    if (_segments[i].is_empty()) { _available.reset(i); }
+    return allocation{block, i};
+  }
+
+  result<block_type *> try_allocate(upstream_t *upstream) noexcept {
+    return ok(allocate_located(upstream)).block;
   }
 
   result<> deallocate(block_type *block, upstream_t *upstream) noexcept {
@@ -136,82 +262,68 @@ public:
         find_segment_for_pointer(reinterpret_cast<std::byte *>(block));
     fail(!segment_id_result, "block not owned by this manager");
 
-    size_t segment_id = *segment_id_result;
-    fail(segment_id >= _high_water_mark, "invalid segment id");
-
-    auto &metadata = _segments[segment_id];
-    fail(!metadata.is_valid(), "invalid segment");
+    return deallocate(block, *segment_id_result, upstream);
+  }
 
-    ok(metadata.deallocate(block, upstream));
+  // O(1) when the caller knows the block's segment, as growing_pool does
+  // from the pointer
+  result<> deallocate(block_type *block, size_t segment_id,
+                      upstream_t *upstream) noexcept {
+    fail(block == nullptr, "cannot deallocate null block");
+    fail(!has_segment(segment_id), "invalid segment");
+
+    ok(_segments[segment_id].deallocate(block, upstream));
+    if (_segments[segment_id].is_valid()) {
+      _available.set(segment_id);
+    } else {
+      // The segment was handed back to the upstream
+      _valid.reset(segment_id);
+      _available.reset(segment_id);
+    }
     return {};
   }
 
   bool owns(block_type *block) const noexcept {
     if (block == nullptr) { return false; }
-
-    for (size_t i = 0; i < _high_water_mark; ++i) {
-      if (_segments[i].owns_block(block)) { return true; }
-    }
-
-    return false;
+    return find_segment_for_pointer(reinterpret_cast<std::byte *>(block))
+        .has_value();
   }
 
   bool has_capacity() const noexcept {
-    for (size_t i = 0; i < _high_water_mark; ++i) {
-      if (_segments[i].is_valid() && !_segments[i].is_full()) { return true; }
-    }
-
-    return _high_water_mark < max_segments;
+    return !_available.none() || _valid.first_clear() < max_segments;
   }
 
-  bool is_empty() const noexcept {
-    for (size_t i = 0; i < _high_water_mark; ++i) {
-      if (_segments[i].is_valid() && !_segments[i].is_empty()) { return false; }
-    }
-    return true;
-  }
+  // Whether no segment has a free block
+  bool is_empty() const noexcept { return _available.none(); }
 
-  // O(n)
-  size_t segment_count() const noexcept {
-    size_t count = 0;
-    for (size_t i = 0; i < _high_water_mark; ++i) {
-      if (_segments[i].is_valid()) { ++count; }
-    }
-    return count;
+  size_t segment_count() const noexcept { return _valid.count(); }
+
+  bool has_segment(size_t segment_id) const noexcept {
+    return segment_id < max_segments && _valid.test(segment_id);
   }
 
   // for pointer resolution by growing_pool
-  result<std::byte *> get_segment_base(uint8_t segment_id) const noexcept {
-    fail(segment_id >= _high_water_mark, "invalid segment id");
-    auto &metadata = _segments[segment_id];
-    fail(!metadata.is_valid(), "segment not valid");
-
-    return static_cast<std::byte *>(static_cast<void *>(metadata.segment_ptr));
+  result<std::byte *> get_segment_base(size_t segment_id) const noexcept {
+    fail(!has_segment(segment_id), "segment not valid");
+    return static_cast<std::byte *>(
+        static_cast<void *>(_segments[segment_id].segment_ptr));
   }
 
+  // Scans the segments, growing_pool finds them through its reverse map
   result<size_t> find_segment_for_pointer(std::byte *ptr) const noexcept {
     auto *block = reinterpret_cast<block_type *>(ptr);
-    for (size_t i = 0; i < _high_water_mark; ++i) {
-      if (_segments[i].is_valid() && _segments[i].owns_block(block)) {
-        return i;
-      }
+    for (size_t i = _valid.first(); i < max_segments; i = _valid.next(i + 1)) {
+      if (_segments[i].owns_block(block)) { return i; }
     }
 
-    return "pointer not owned by manager";
-  }
-
-private:
-  result<size_t> find_free_slot() const noexcept {
-    for (size_t i = 0; i < max_segments; ++i) {
-      if (!_segments[i].is_valid()) { return i; }
-    }
-    fail("free slot not found").silent();
+    fail("pointer not owned by manager").silent();
     return {};
   }
 
-  result<block_type *> allocate_new_segment(upstream_t *upstream) noexcept {
-    size_t slot = ok(find_free_slot());
-    if (slot >= _high_water_mark) { _high_water_mark = slot + 1; }
+private:
+  result<allocation> allocate_new_segment(upstream_t *upstream) noexcept {
+    size_t slot = _valid.first_clear();
+    fail(slot == max_segments, "free slot not found").silent();
 
     auto upstream_block = ok(upstream->allocate_block());
     typename upstream_t::pointer_type upstream_ptr = upstream_block;
@@ -221,7 +333,9 @@ private:
         _segments[slot].freelist_head, _segments[slot].freelist_count);
 
     _segments[slot].segment_ptr = upstream_ptr;
+    _valid.set(slot);
+    _available.set(slot);
 
-    return try_allocate(upstream);
+    return allocate_located(upstream);
   }
 };
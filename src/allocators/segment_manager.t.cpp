@@ -105,3 +105,61 @@ TEST_F(SegmentManagerTest, OwnershipCheck) {
 
   manager2.cleanup(&upstream);
 }
+
+TEST_F(SegmentManagerTest, FreedSegmentSlotIsReused) {
+  constexpr size_t blocks_per_segment = seg_manager::blocks_per_segment;
+  std::array<seg_manager::allocation, blocks_per_segment * 3> blocks;
+
+  for (auto &block : blocks) {
+    block = unwrap(manager.allocate_located(&upstream));
+  }
+  EXPECT_EQ(manager.segment_count(), 3);
+  EXPECT_TRUE(manager.is_empty());
+
+  // Freeing every block of the middle segment hands it back to the upstream
+  for (auto &block : blocks) {
+    if (block.segment_id == 1) {
+      ASSERT_TRUE(manager.deallocate(block.block, 1, &upstream));
+    }
+  }
+  EXPECT_EQ(manager.segment_count(), 2);
+  EXPECT_FALSE(manager.has_segment(1));
+  EXPECT_TRUE(manager.has_capacity());
+
+  auto refill = unwrap(manager.allocate_located(&upstream));
+  EXPECT_EQ(refill.segment_id, 1);
+  EXPECT_EQ(manager.available_count(), blocks_per_segment - 1);
+  ASSERT_TRUE(manager.deallocate(refill.block, &upstream));
+
+  for (auto &block : blocks) {
+    if (block.segment_id != 1) {
+      ASSERT_TRUE(manager.deallocate(block.block, &upstream));
+    }
+  }
+  EXPECT_EQ(manager.segment_count(), 0);
+}
+
+TEST(SegmentBitmapTest, SearchesAcrossWords) {
+  segment_bitmap<100> bitmap;
+  EXPECT_TRUE(bitmap.none());
+  EXPECT_EQ(bitmap.first(), 100);
+  EXPECT_EQ(bitmap.first_clear(), 0);
+
+  bitmap.set(3);
+  bitmap.set(70);
+  bitmap.set(99);
+  EXPECT_EQ(bitmap.count(), 3);
+  EXPECT_EQ(bitmap.first(), 3);
+  EXPECT_EQ(bitmap.next(4), 70);
+  EXPECT_EQ(bitmap.next(71), 99);
+  EXPECT_EQ(bitmap.next(100), 100);
+
+  for (size_t i = 0; i < 100; ++i) {
+    bitmap.set(i);
+  }
+  EXPECT_EQ(bitmap.first_clear(), 100);
+  bitmap.reset(65);
+  EXPECT_EQ(bitmap.first_clear(), 65);
+  EXPECT_FALSE(bitmap.test(65));
+  EXPECT_TRUE(bitmap.test(64));
+}
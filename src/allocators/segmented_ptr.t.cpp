@@ -271,6 +271,33 @@ TEST_F(GrowingPoolPtrTest, AllocateAndResolve) {
   pool.deallocate_block(ptr);
 }
 
+TEST_F(GrowingPoolPtrTest, UncheckedResolveMatchesPool) {
+  constexpr size_t block_count = pool_type::manager_type::max_block_count * 3;
+  std::vector<ptr_type> ptrs;
+
+  // The segments are freed and come back from other upstream blocks in the
+  // second round, which the table must follow
+  for (int round = 0; round < 2; ++round) {
+    for (size_t i = 0; i < block_count; ++i) {
+      ptrs.push_back(unwrap(pool.allocate_block()));
+    }
+
+    for (auto ptr : ptrs) {
+      std::byte *base = unwrap(
+          pool.get_segment_base(ptr.get_manager_id(), ptr.get_segment_id()));
+      EXPECT_EQ(static_cast<void *>(ptr.resolve_unchecked()),
+                static_cast<void *>(base + ptr.get_offset() * 8));
+      EXPECT_EQ(static_cast<void *>(ptr.resolve_unchecked()),
+                static_cast<void *>(ptr));
+    }
+
+    for (auto ptr : ptrs) {
+      ASSERT_TRUE(pool.deallocate_block(ptr));
+    }
+    ptrs.clear();
+  }
+}
+
 TEST_F(GrowingPoolPtrTest, NullResolvesToNullptr) {
   ptr_type null_ptr;
   void *resolved = static_cast<void *>(null_ptr);
@@ -308,6 +335,40 @@ TEST_F(GrowingPoolPtrTest, ConstructFromRawPointer) {
   pool.deallocate_block(ptr1);
 }
 
+TEST_F(GrowingPoolPtrTest, ConstructFromRawPointerAcrossManagers) {
+  constexpr size_t block_count = pool_type::manager_type::max_block_count * 3;
+  std::vector<ptr_type> ptrs;
+  for (size_t i = 0; i < block_count; ++i) {
+    ptrs.push_back(unwrap(pool.allocate_block()));
+  }
+
+  for (auto ptr : ptrs) {
+    ptr_type converted{static_cast<void *>(ptr)};
+    EXPECT_EQ(converted.get_manager_id(), ptr.get_manager_id());
+    EXPECT_EQ(converted.get_segment_id(), ptr.get_segment_id());
+    EXPECT_EQ(converted.get_offset(), ptr.get_offset());
+  }
+
+  for (auto ptr : ptrs) {
+    ASSERT_TRUE(pool.deallocate_block(ptr));
+  }
+}
+
+TEST_F(GrowingPoolPtrTest, ConstructFromForeignRawPointerIsNull) {
+  // An upstream block that is not one of the pool's segments
+  auto foreign = unwrap(upstream.allocate_block());
+  ptr_type from_foreign{static_cast<void *>(foreign)};
+  EXPECT_EQ(from_foreign, nullptr);
+  upstream.deallocate_block(foreign);
+
+  // A segment handed back to the upstream once its blocks are all free
+  auto ptr = unwrap(pool.allocate_block());
+  void *raw = static_cast<void *>(ptr);
+  ASSERT_TRUE(pool.deallocate_block(ptr));
+  ptr_type from_freed{raw};
+  EXPECT_EQ(from_freed, nullptr);
+}
+
 TEST_F(GrowingPoolPtrTest, ConstructFromNullRawPointer) {
   void *raw_null = nullptr;
   ptr_type ptr{raw_null};
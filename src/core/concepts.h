@@ -50,6 +50,12 @@ concept provides_management = requires(T &alloc, const T &c_alloc) {
   { c_alloc.size() } -> std::same_as<std::size_t>;
 };
 
+// Allocators that report how many of their blocks are still free
+template <typename T>
+concept provides_availability = requires(const T &alloc) {
+  { alloc.available() } -> std::same_as<std::size_t>;
+};
+
 template <typename T>
 concept managed = memory_resource_like<T> && provides_management<T>;
 
@@ -62,3 +68,17 @@ concept contiguous_allocator = is_homogenous<T> && provides_offset<T>;
 
 template <typename T>
 concept is_nothrow = std::is_nothrow_destructible_v<T>;
+
+// Allocators tagged per_thread<tag> keep their context per thread instead of
+// per type: the thin_ptr base, the registered growing_pool and its hint
+// caches, and the allocator pointers containers store statically. Every
+// thread can then run its own arena of one allocator type.
+template <typename tag> struct per_thread {};
+
+template <typename tag> inline constexpr bool is_per_thread_v = false;
+template <typename tag>
+inline constexpr bool is_per_thread_v<per_thread<tag>> = true;
+
+template <typename T>
+concept per_thread_allocator = requires { typename T::unique_tag; } &&
+                               is_per_thread_v<typename T::unique_tag>;
@@ -0,0 +1,117 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#if defined(__linux__)
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Lets consumers sleep until a producer publishes something, without costing
+// the producer a syscall while nobody sleeps.
+//
+// A consumer calls prepare_wait(), re-checks its condition, then calls either
+// cancel_wait() or wait(key). A producer calls notify_*() after publishing.
+// The seq_cst fences on both sides ensure that either the consumer's re-check
+// sees the published data or the producer sees the registered waiter, so a
+// wakeup is never lost. While no waiter is registered, notify_*() is a fence
+// and a load.
+//
+// std::atomic::wait has no timed form. On Linux both waiting and waking use
+// futex(2) on the sequence word directly (libstdc++'s notify skips the wake
+// for waiters it did not register itself, so the two can't be mixed).
+// Elsewhere untimed waits use std::atomic::wait and timed waits poll.
+class event_count {
+  std::atomic<uint32_t> _sequence{0};
+  std::atomic<uint32_t> _waiters{0};
+
+public:
+  uint32_t prepare_wait() noexcept {
+    _waiters.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return _sequence.load(std::memory_order_acquire);
+  }
+
+  void cancel_wait() noexcept {
+    _waiters.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  // Sleeps until a notify after prepare_wait() returned key
+  void wait(uint32_t key) noexcept {
+    while (_sequence.load(std::memory_order_acquire) == key) {
+#if defined(__linux__)
+      futex(FUTEX_WAIT_PRIVATE, key, nullptr);
+#else
+      _sequence.wait(key, std::memory_order_acquire);
+#endif
+    }
+    cancel_wait();
+  }
+
+  // Returns false if the deadline passed without a notify
+  bool wait_until(uint32_t key,
+                  std::chrono::steady_clock::time_point deadline) noexcept {
+    while (_sequence.load(std::memory_order_acquire) == key) {
+      auto remaining = deadline - std::chrono::steady_clock::now();
+      if (remaining <= remaining.zero()) {
+        cancel_wait();
+        return false;
+      }
+#if defined(__linux__)
+      auto secs = std::chrono::duration_cast<std::chrono::seconds>(remaining);
+      timespec timeout{
+          .tv_sec = static_cast<time_t>(secs.count()),
+          .tv_nsec = static_cast<long>(
+              std::chrono::duration_cast<std::chrono::nanoseconds>(remaining -
+                                                                   secs)
+                  .count())};
+      futex(FUTEX_WAIT_PRIVATE, key, &timeout);
+#else
+      std::this_thread::sleep_for(
+          std::min<std::chrono::steady_clock::duration>(
+              remaining, std::chrono::milliseconds(1)));
+#endif
+    }
+    cancel_wait();
+    return true;
+  }
+
+  void notify_one() noexcept {
+    if (!publish()) { return; }
+#if defined(__linux__)
+    futex(FUTEX_WAKE_PRIVATE, 1, nullptr);
+#else
+    _sequence.notify_one();
+#endif
+  }
+
+  void notify_all() noexcept {
+    if (!publish()) { return; }
+#if defined(__linux__)
+    futex(FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr);
+#else
+    _sequence.notify_all();
+#endif
+  }
+
+private:
+  // Bumps the sequence if anyone may be sleeping on it
+  bool publish() noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_waiters.load(std::memory_order_relaxed) == 0) { return false; }
+    _sequence.fetch_add(1, std::memory_order_release);
+    return true;
+  }
+
+#if defined(__linux__)
+  void futex(int op, uint32_t value, const timespec *timeout) noexcept {
+    static_assert(sizeof(_sequence) == sizeof(uint32_t));
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&_sequence), op, value,
+            timeout, nullptr, 0);
+  }
+#endif
+};
@@ -5,6 +5,7 @@
 #include <iterators/iterator_facade.h>
 #include <print>
 #include <result/result.h>
+#include <utility>
 
 template <typename node_ptr>
 concept intrusive_node = requires(node_ptr ptr) {
@@ -29,13 +30,35 @@ private:
 
 public:
   intrusive_slist() = default;
-  // Non-copyable, non-movable (contains external node pointers)
+  // Non-copyable (contains external node pointers). Moving hands the nodes
+  // over and leaves the source empty; nodes linked in the target before a
+  // move assignment are dropped, not freed.
   intrusive_slist(const intrusive_slist &) = delete;
+  // Adopts a chain that is already linked, e.g. one recovered from a file
+  intrusive_slist(node_ptr head, node_ptr tail, size_type count) noexcept
+      : _head(head), _tail(tail), _count(count) {}
   intrusive_slist &operator=(const intrusive_slist &) = delete;
-  intrusive_slist(intrusive_slist &&) = delete;
-  intrusive_slist &operator=(intrusive_slist &&) = delete;
+  intrusive_slist(intrusive_slist &&other) noexcept
+      : _head(other._head), _tail(other._tail), _count(other._count) {
+    other.clear();
+  }
+  intrusive_slist &operator=(intrusive_slist &&other) noexcept {
+    if (this != &other) {
+      _head = other._head;
+      _tail = other._tail;
+      _count = other._count;
+      other.clear();
+    }
+    return *this;
+  }
   ~intrusive_slist() = default;
 
+  void swap(intrusive_slist &other) noexcept {
+    std::swap(_head, other._head);
+    std::swap(_tail, other._tail);
+    std::swap(_count, other._count);
+  }
+
   void push_front(node_ptr node) noexcept {
     fatal(_count >= max_size, "intrusive_slist capacity exceeded");
 
@@ -79,6 +102,22 @@ public:
     ++_count;
   }
 
+  // O(1) - links other's nodes after the tail and leaves other empty
+  void splice_back(intrusive_slist &other) noexcept {
+    if (other.empty()) { return; }
+    fatal(other._count > max_size - _count,
+          "intrusive_slist capacity exceeded");
+
+    if (_tail == nullptr) {
+      _head = other._head;
+    } else {
+      _tail->next = other._head;
+    }
+    _tail = other._tail;
+    _count += other._count;
+    other.clear();
+  }
+
   // O(n) - must traverse to find node before tail
   node_ptr pop_back() noexcept {
     if (_head == _tail) {
@@ -0,0 +1,49 @@
+#pragma once
+#include <allocators/test_allocator.h>
+#include <mutex>
+#include <queue.h>
+
+// ============================================================================
+// Locked Queue
+// ============================================================================
+// Baseline for the concurrent queue benchmarks: the regular queue behind a
+// mutex, on a heap-backed allocator. simple_test_allocator is stateless, so
+// instances may share its allocator storage across threads.
+// ============================================================================
+
+struct locked_allocator : simple_test_allocator {
+  static constexpr size_t max_block_count = 1 << 16;
+  static constexpr size_t total_size = block_size * max_block_count;
+};
+
+// Counted, so the producer's size() check does not walk the chain
+using unlocked_queue =
+    queue<int, 16, locked_allocator, locked_allocator, uint32_t>;
+
+class locked_queue {
+public:
+  locked_queue() : _queue(&_local_alloc, &_list_alloc) {}
+
+  result<> push(int value) noexcept {
+    std::lock_guard lock(_mutex);
+    return _queue.push(value);
+  }
+
+  // Empty polls are expected here and must not reach queue::pop's log
+  result<int> pop() noexcept {
+    std::lock_guard lock(_mutex);
+    if (_queue.empty()) { return error::generic; }
+    return _queue.pop();
+  }
+
+  size_t size() noexcept {
+    std::lock_guard lock(_mutex);
+    return _queue.size();
+  }
+
+private:
+  std::mutex _mutex;
+  locked_allocator _local_alloc;
+  locked_allocator _list_alloc;
+  unlocked_queue _queue;
+};
@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+#include <local_buffer.h>
+#include <locked_queue.h>
+#include <memory>
+#include <mpmc_queue.h>
+
+// ============================================================================
+// Configuration
+// ============================================================================
+// Every thread alternates push and pop on one shared queue, so the queue
+// stays short while all threads contend on both ends. Compare items/s across
+// thread counts against the mutex-wrapped queue.
+// ============================================================================
+
+constexpr size_t ops_per_iteration = 64;
+
+constexpr size_t mpmc_block_size = 16384;
+constexpr size_t mpmc_block_count = 64;
+constexpr size_t mpmc_segment_capacity = 1024;
+
+using mpmc_alloc = local_buffer(mpmc_block_size, mpmc_block_count);
+using bench_mpmc_queue = mpmc_queue<int, mpmc_segment_capacity, mpmc_alloc>;
+
+static std::unique_ptr<mpmc_alloc> mpmc_allocator;
+static std::unique_ptr<bench_mpmc_queue> mpmc;
+static std::unique_ptr<locked_queue> locked;
+
+// Setup and teardown run once, before the threads start and after they join
+static void create_mpmc(const benchmark::State &) {
+  mpmc_allocator = std::make_unique<mpmc_alloc>();
+  mpmc = std::make_unique<bench_mpmc_queue>(mpmc_allocator.get());
+}
+
+static void destroy_mpmc(const benchmark::State &) {
+  mpmc.reset();
+  mpmc_allocator.reset();
+}
+
+static void create_locked(const benchmark::State &) {
+  locked = std::make_unique<locked_queue>();
+}
+
+static void destroy_locked(const benchmark::State &) { locked.reset(); }
+
+// ============================================================================
+// Contention
+// ============================================================================
+
+template <typename queue_type>
+static void push_pop_pairs(benchmark::State &state, queue_type &q) {
+  int value = static_cast<int>(state.thread_index());
+  for (auto _ : state) {
+    for (size_t i = 0; i < ops_per_iteration; ++i) {
+      q.push(value);
+      // Another thread may have taken our element, retry until one arrives
+      result<int> popped = q.pop();
+      while (!popped) { popped = q.pop(); }
+      benchmark::DoNotOptimize(popped);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * ops_per_iteration);
+}
+
+static void BM_MpmcContention(benchmark::State &state) {
+  push_pop_pairs(state, *mpmc);
+}
+BENCHMARK(BM_MpmcContention)
+    ->Setup(create_mpmc)
+    ->Teardown(destroy_mpmc)
+    ->ThreadRange(1, 32)
+    ->UseRealTime();
+
+static void BM_LockedQueueContention(benchmark::State &state) {
+  push_pop_pairs(state, *locked);
+}
+BENCHMARK(BM_LockedQueueContention)
+    ->Setup(create_locked)
+    ->Teardown(destroy_locked)
+    ->ThreadRange(1, 32)
+    ->UseRealTime();
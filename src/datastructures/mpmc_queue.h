@@ -0,0 +1,317 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <event_count.h>
+#include <result/result.h>
+#include <types.h>
+
+// The allocators are not thread-safe, so every call into them is serialized.
+// This happens once per segment, not per element.
+template <typename allocator_type> struct mpmc_queue_allocator_storage {
+  inline static allocator_type *_allocator{nullptr};
+  inline static std::mutex _mutex;
+};
+
+// Lock-free multi-producer/multi-consumer FIFO queue implemented as a linked
+// list of fixed-size segments.
+//
+// Producers claim slots with a fetch_add on the segment's enqueue counter and
+// publish each slot through its ready flag. Consumers claim slots with a CAS
+// on the dequeue counter, which never passes the enqueue counter, and wait
+// for the ready flag of a claimed slot (its producer has already claimed it).
+// Whoever finds a segment exhausted links or follows its successor and moves
+// the shared head/tail link forward.
+//
+// Reclamation uses split reference counts. Each link is a single 64-bit word
+// holding the segment's thin pointer offset and a count of threads that
+// borrowed the segment through it, so borrowing is one fetch_add. The thread
+// that moves a link on transfers those borrows into the segment's own count
+// and drops the reference the link held; the segment is freed when both
+// links have moved past it and every borrow has been returned.
+template <is_nothrow T, size_t segment_capacity,
+          contiguous_allocator allocator_type>
+class mpmc_queue {
+public:
+  using storage = mpmc_queue_allocator_storage<allocator_type>;
+
+  static constexpr size_t capacity_v = segment_capacity;
+  static constexpr size_t cache_line =
+      std::hardware_destructive_interference_size;
+
+  static_assert(segment_capacity > 0, "segment capacity must be > 0");
+  static_assert(segment_capacity <= UINT32_MAX / 2,
+                "segment capacity must leave room for failed claims");
+
+private:
+  struct segment;
+  using segment_pointer =
+      typename allocator_type::pointer_type::template rebind<segment>;
+  using offset_type = typename allocator_type::offset_type;
+
+  // Weight of a link's reference, large enough that returned borrows can't
+  // bring the count to zero before the link has moved on
+  static constexpr int64_t link_ref = int64_t{1} << 32;
+  static constexpr uint64_t borrow_mask = (uint64_t{1} << 32) - 1;
+
+  struct slot {
+    std::atomic<bool> ready{false};
+    alignas(T) std::byte bytes[sizeof(T)];
+
+    T *get() noexcept { return std::launder(reinterpret_cast<T *>(bytes)); }
+  };
+
+  struct segment {
+    std::atomic<uint32_t> enqueued{0};
+    std::byte _producer_padding[cache_line];
+    std::atomic<uint32_t> dequeued{0};
+    std::atomic<int64_t> refs{2 * link_ref}; // head and tail link
+    std::atomic<segment_pointer> next{segment_pointer(nullptr)};
+    slot slots[segment_capacity];
+  };
+
+public:
+  static_assert(sizeof(segment) <= allocator_type::block_size,
+                "allocator block_size too small for segment");
+  static_assert(allocator_type::block_size % alignof(segment) == 0,
+                "allocator block_size must be a multiple of segment alignment");
+
+private:
+  alignas(cache_line) std::atomic<uint64_t> _head{0};
+  alignas(cache_line) std::atomic<uint64_t> _tail{0};
+
+  // Sleeping consumers, read by producers after every push
+  alignas(cache_line) event_count _available;
+
+public:
+  explicit mpmc_queue(allocator_type *allocator) {
+    fatal(allocator == nullptr, "Allocator cannot be null");
+    storage::_allocator = allocator;
+
+    auto first = allocate_segment();
+    fatal(!first, "Failed to allocate mpmc_queue segment");
+    _head.store(pack(*first), std::memory_order_relaxed);
+    _tail.store(pack(*first), std::memory_order_relaxed);
+  }
+
+  // No other thread may be using the queue
+  ~mpmc_queue() {
+    while (pop()) {}
+
+    segment *head = unpack(_head.load(std::memory_order_relaxed));
+    segment *tail = unpack(_tail.load(std::memory_order_relaxed));
+
+    // Consumers may have moved head onto a segment tail has not reached yet
+    segment *seg = head;
+    if (tail != head && unpack_next(tail) == head) { seg = tail; }
+
+    while (seg != nullptr) {
+      segment *next = unpack_next(seg);
+      deallocate_segment(seg);
+      seg = next;
+    }
+  }
+
+  mpmc_queue(const mpmc_queue &) = delete;
+  mpmc_queue &operator=(const mpmc_queue &) = delete;
+  mpmc_queue(mpmc_queue &&) = delete;
+  mpmc_queue &operator=(mpmc_queue &&) = delete;
+
+  template <typename U>
+    requires std::constructible_from<T, U>
+  result<> push(U &&value) noexcept {
+    return emplace(std::forward<U>(value));
+  }
+
+  template <typename... Args>
+    requires std::constructible_from<T, Args...>
+  result<> emplace(Args &&...args) noexcept {
+    while (true) {
+      segment *seg = borrow(_tail);
+
+      // Skip the fetch_add once the segment is known to be full, so the
+      // counter only overshoots by the number of racing producers
+      if (seg->enqueued.load(std::memory_order_relaxed) < segment_capacity) {
+        uint32_t index = seg->enqueued.fetch_add(1, std::memory_order_relaxed);
+        if (index < segment_capacity) {
+          slot &target = seg->slots[index];
+          new (target.bytes) T(std::forward<Args>(args)...);
+          target.ready.store(true, std::memory_order_release);
+          give_back(_tail, seg);
+          _available.notify_one();
+          return {};
+        }
+      }
+
+      auto next = link_next(seg);
+      if (next) { move_link(_tail, seg, *next); }
+      give_back(_tail, seg);
+      if (!next) { return std::unexpected(next.error()); }
+    }
+  }
+
+  // Failing on an empty queue is expected while polling, so it is not logged
+  result<T> pop() noexcept {
+    while (true) {
+      segment *seg = borrow(_head);
+
+      uint32_t index = seg->dequeued.load(std::memory_order_relaxed);
+      while (index < produced(seg)) {
+        if (seg->dequeued.compare_exchange_weak(index, index + 1,
+                                                std::memory_order_relaxed)) {
+          T value = take(seg->slots[index]);
+          give_back(_head, seg);
+          return value;
+        }
+      }
+
+      // Caught up with the producers, or every slot is claimed and there is
+      // no successor yet
+      segment *next = index < segment_capacity ? nullptr : unpack_next(seg);
+      if (next == nullptr) { give_back(_head, seg); }
+      fail(next == nullptr, "Cannot pop from empty mpmc_queue").silent();
+
+      move_link(_head, seg, next);
+      give_back(_head, seg);
+    }
+  }
+
+  // Sleeps while the queue is empty instead of polling
+  T pop_wait() noexcept {
+    while (true) {
+      if (auto value = pop()) { return std::move(*value); }
+
+      uint32_t key = _available.prepare_wait();
+      if (auto value = pop()) {
+        _available.cancel_wait();
+        return std::move(*value);
+      }
+      _available.wait(key);
+    }
+  }
+
+  template <typename rep, typename period>
+  result<T> pop_wait_for(std::chrono::duration<rep, period> timeout) noexcept {
+    auto deadline =
+        std::chrono::steady_clock::now() +
+        std::chrono::ceil<std::chrono::steady_clock::duration>(timeout);
+
+    while (true) {
+      if (auto value = pop()) { return value; }
+
+      uint32_t key = _available.prepare_wait();
+      if (auto value = pop()) {
+        _available.cancel_wait();
+        return value;
+      }
+      fail(!_available.wait_until(key, deadline),
+           "Timed out waiting on empty mpmc_queue")
+          .silent();
+    }
+  }
+
+private:
+  static uint64_t pack(segment *seg) noexcept {
+    return uint64_t{segment_pointer(seg).offset()} << 32;
+  }
+
+  static segment *unpack(uint64_t word) noexcept {
+    return segment_pointer::from_offset(static_cast<offset_type>(word >> 32));
+  }
+
+  static segment *unpack_next(segment *seg) noexcept {
+    return seg->next.load(std::memory_order_acquire);
+  }
+
+  static uint32_t produced(segment *seg) noexcept {
+    return std::min<uint32_t>(seg->enqueued.load(std::memory_order_relaxed),
+                              segment_capacity);
+  }
+
+  // The producer claimed the slot before the consumer could, but may not
+  // have finished constructing the element yet
+  static T take(slot &source) noexcept {
+    while (!source.ready.load(std::memory_order_acquire)) {}
+    T *ptr = source.get();
+    T value = std::move(*ptr);
+    ptr->~T();
+    return value;
+  }
+
+  // Segment the link points at, kept alive until give_back
+  static segment *borrow(std::atomic<uint64_t> &link) noexcept {
+    return unpack(link.fetch_add(1, std::memory_order_acquire));
+  }
+
+  static void give_back(std::atomic<uint64_t> &link, segment *seg) noexcept {
+    uint64_t target = pack(seg);
+    uint64_t word = link.load(std::memory_order_relaxed);
+    while ((word & ~borrow_mask) == target) {
+      if (link.compare_exchange_weak(word, word - 1,
+                                     std::memory_order_release,
+                                     std::memory_order_relaxed)) {
+        return;
+      }
+    }
+
+    // The link moved on and transferred the borrow to the segment
+    drop_refs(seg, 1);
+  }
+
+  // Only one thread wins the move and transfers the link's borrows
+  static void move_link(std::atomic<uint64_t> &link, segment *seg,
+                        segment *next) noexcept {
+    uint64_t target = pack(seg);
+    uint64_t word = link.load(std::memory_order_relaxed);
+    while ((word & ~borrow_mask) == target) {
+      if (link.compare_exchange_weak(word, pack(next),
+                                     std::memory_order_acq_rel,
+                                     std::memory_order_relaxed)) {
+        int64_t borrowed = static_cast<int64_t>(word & borrow_mask);
+        drop_refs(seg, link_ref - borrowed);
+        return;
+      }
+    }
+  }
+
+  static void drop_refs(segment *seg, int64_t count) noexcept {
+    if (seg->refs.fetch_sub(count, std::memory_order_acq_rel) == count) {
+      deallocate_segment(seg);
+    }
+  }
+
+  // Successor of a full segment, linking a new one if nobody has yet
+  static result<segment *> link_next(segment *seg) noexcept {
+    segment_pointer next = seg->next.load(std::memory_order_acquire);
+    if (next) { return static_cast<segment *>(next); }
+
+    segment *fresh = ok(allocate_segment());
+    if (seg->next.compare_exchange_strong(next, segment_pointer(fresh),
+                                          std::memory_order_acq_rel,
+                                          std::memory_order_acquire)) {
+      return fresh;
+    }
+    deallocate_segment(fresh);
+    return static_cast<segment *>(next);
+  }
+
+  static result<segment *> allocate_segment() noexcept {
+    std::unique_lock lock(storage::_mutex);
+    auto block = ok(storage::_allocator->allocate_block());
+    lock.unlock();
+    return new (static_cast<void *>(block)) segment;
+  }
+
+  static void deallocate_segment(segment *seg) noexcept {
+    seg->~segment();
+    typename allocator_type::pointer_type block(static_cast<void *>(seg));
+    std::lock_guard lock(storage::_mutex);
+    storage::_allocator->deallocate_block(block);
+  }
+};
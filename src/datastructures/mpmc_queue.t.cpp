@@ -0,0 +1,164 @@
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <local_buffer.h>
+#include <memory>
+#include <mpmc_queue.h>
+#include <thread>
+#include <vector>
+
+constexpr int segment_capacity = 8;
+
+// 8 segments in total, so anything beyond that relies on reclamation
+using local_alloc = local_buffer(256, 8);
+using test_queue = mpmc_queue<int, segment_capacity, local_alloc>;
+
+class MpmcQueueTest : public ::testing::Test {
+protected:
+  local_alloc allocator;
+  test_queue q{&allocator};
+};
+
+// ============================================================================
+// Single-Threaded Behavior
+// ============================================================================
+
+TEST_F(MpmcQueueTest, PopFromEmptyFails) {
+  EXPECT_FALSE(q.pop().has_value());
+}
+
+TEST_F(MpmcQueueTest, MaintainsFIFOOrderAcrossSegments) {
+  for (int i = 0; i < segment_capacity * 3 + 1; ++i) {
+    ASSERT_TRUE(q.push(i).has_value());
+  }
+  for (int i = 0; i < segment_capacity * 3 + 1; ++i) {
+    EXPECT_EQ(*q.pop(), i);
+  }
+  EXPECT_FALSE(q.pop().has_value());
+}
+
+TEST_F(MpmcQueueTest, EmplaceConstructsInPlace) {
+  ASSERT_TRUE(q.emplace(42).has_value());
+  EXPECT_EQ(*q.pop(), 42);
+}
+
+TEST_F(MpmcQueueTest, ReclaimsConsumedSegments) {
+  for (int cycle = 0; cycle < 100; ++cycle) {
+    for (int i = 0; i < segment_capacity * 4; ++i) {
+      ASSERT_TRUE(q.push(cycle * 1000 + i).has_value())
+          << "segments not reclaimed in cycle " << cycle;
+    }
+    for (int i = 0; i < segment_capacity * 4; ++i) {
+      EXPECT_EQ(*q.pop(), cycle * 1000 + i);
+    }
+  }
+}
+
+TEST_F(MpmcQueueTest, EmptyPopsDoNotLeakSegments) {
+  // Consumers that find a drained segment move head onto the successor
+  for (int cycle = 0; cycle < 100; ++cycle) {
+    for (int i = 0; i < segment_capacity; ++i) {
+      ASSERT_TRUE(q.push(i).has_value());
+    }
+    for (int i = 0; i < segment_capacity; ++i) {
+      EXPECT_EQ(*q.pop(), i);
+    }
+    EXPECT_FALSE(q.pop().has_value());
+  }
+}
+
+TEST_F(MpmcQueueTest, PopWaitForTimesOutOnEmptyQueue) {
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(q.pop_wait_for(std::chrono::milliseconds(20)).has_value());
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(20));
+}
+
+// ============================================================================
+// Producer/Consumer Threads
+// ============================================================================
+
+TEST(MpmcQueueThreadTest, DeliversEveryValueOnceInProducerOrder) {
+  using thread_alloc = local_buffer(512, 512);
+  using thread_queue = mpmc_queue<int, 48, thread_alloc>;
+
+  constexpr int producers = 4;
+  constexpr int consumers = 4;
+  constexpr int per_producer = 20000;
+  // Keep the producers well within the allocator's 512 segments
+  constexpr int max_in_flight = 48 * 256;
+
+  auto allocator = std::make_unique<thread_alloc>();
+  thread_queue q{allocator.get()};
+
+  std::atomic<int> pushed{0};
+  std::atomic<int> popped{0};
+  std::vector<std::atomic<int>> seen(producers * per_producer);
+  std::vector<std::thread> threads;
+
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p] {
+      for (int i = 0; i < per_producer; ++i) {
+        while (pushed.load() - popped.load() >= max_in_flight) {
+          std::this_thread::yield();
+        }
+        ASSERT_TRUE(q.push(p * per_producer + i).has_value());
+        pushed.fetch_add(1);
+      }
+    });
+  }
+
+  for (int c = 0; c < consumers; ++c) {
+    threads.emplace_back([&] {
+      // Values from one producer must arrive in the order it pushed them
+      std::vector<int> last(producers, -1);
+      while (popped.load() < producers * per_producer) {
+        auto value = q.pop();
+        if (!value) {
+          std::this_thread::yield();
+          continue;
+        }
+        int producer = *value / per_producer;
+        EXPECT_GT(*value, last[producer]);
+        last[producer] = *value;
+        seen[*value].fetch_add(1);
+        popped.fetch_add(1);
+      }
+    });
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (auto &count : seen) {
+    EXPECT_EQ(count.load(), 1);
+  }
+  EXPECT_FALSE(q.pop().has_value());
+}
+
+TEST(MpmcQueueThreadTest, PopWaitWakesEverySleepingConsumer) {
+  using wait_alloc = local_buffer(512, 8);
+  using wait_queue = mpmc_queue<int, 48, wait_alloc>;
+
+  constexpr int consumers = 4;
+  auto allocator = std::make_unique<wait_alloc>();
+  wait_queue q{allocator.get()};
+
+  std::atomic<int> sum{0};
+  std::vector<std::thread> threads;
+  for (int c = 0; c < consumers; ++c) {
+    threads.emplace_back([&] { sum.fetch_add(q.pop_wait()); });
+  }
+
+  // Give the consumers time to fall asleep
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  for (int i = 1; i <= consumers; ++i) {
+    ASSERT_TRUE(q.push(i).has_value());
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(sum.load(), consumers * (consumers + 1) / 2);
+}
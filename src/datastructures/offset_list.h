@@ -11,10 +11,17 @@
 #include <result/result.h>
 #include <types.h>
 
-template <typename allocator_type> struct offset_list_allocator_storage {
+template <typename allocator_type,
+          bool = per_thread_allocator<allocator_type>>
+struct offset_list_allocator_storage {
   inline static allocator_type *_allocator{nullptr};
 };
 
+template <typename allocator_type>
+struct offset_list_allocator_storage<allocator_type, true> {
+  inline static thread_local allocator_type *_allocator{nullptr};
+};
+
 // Singly-linked list using segmented pointers
 template <is_nothrow T, is_homogenous allocator_type = simple_test_allocator>
 class offset_list
@@ -24,6 +31,9 @@ public:
   struct node;
   using node_pointer =
       typename allocator_type::pointer_type::template rebind<node>;
+  // A list can never hold more nodes than its allocator can hand out
+  using list_type =
+      intrusive_slist<node_pointer, allocator_type::max_block_count>;
   using storage = offset_list_allocator_storage<allocator_type>;
 
   struct node {
@@ -36,7 +46,7 @@ public:
   static_assert(allocator_type::block_size % alignof(node) == 0,
                 "Allocator block_size must be a multiple of node alignment");
 
-  intrusive_slist<node_pointer> _list;
+  list_type _list;
 
 private:
   node_pointer allocate_node(auto &&...args) noexcept {
@@ -48,7 +58,7 @@ private:
     return result;
   }
 
-  void deallocate_node(node_pointer ptr) noexcept {
+  static void deallocate_node(node_pointer ptr) noexcept {
     ptr->~node();
     storage::_allocator->deallocate_block(ptr);
   }
@@ -60,8 +70,21 @@ private:
 public:
   offset_list(const offset_list &) = delete;
   offset_list &operator=(const offset_list &) = delete;
-  offset_list(offset_list &&) = delete;
-  offset_list &operator=(offset_list &&) = delete;
+
+  // Lists of one type share their allocator, so moving only hands over the
+  // head and tail. O(1)
+  offset_list(offset_list &&other) noexcept : _list(std::move(other._list)) {}
+
+  // Frees this list's nodes, then takes other's
+  offset_list &operator=(offset_list &&other) noexcept {
+    if (this != &other) {
+      clear();
+      _list = std::move(other._list);
+    }
+    return *this;
+  }
+
+  void swap(offset_list &other) noexcept { _list.swap(other._list); }
 
   // Default constructor - uses static test allocator
   offset_list() : offset_list(&default_allocator) {}
@@ -71,6 +94,13 @@ public:
     storage::_allocator = allocator;
   }
 
+  // Point lists of this type at allocator without constructing one, for
+  // lists recovered from a file-backed arena
+  static void attach(allocator_type *allocator) noexcept {
+    fatal(allocator == nullptr, "Allocator cannot be null");
+    storage::_allocator = allocator;
+  }
+
   ~offset_list() {
     clear();
     // NOTE: Don't clear static storage here when using multiple instances.
@@ -96,6 +126,21 @@ public:
     return {};
   }
 
+  template <typename U>
+    requires std::constructible_from<T, U>
+  result<> push_back(U &&value) noexcept {
+    node_pointer new_node = allocate_node(std::forward<U>(value));
+    _list.push_back(new_node);
+    return {};
+  }
+
+  // O(1) - links after the tail
+  result<> emplace_back(auto &&...args) noexcept {
+    node_pointer new_node = allocate_node(exforward(args)...);
+    _list.push_back(new_node);
+    return {};
+  }
+
   result<T> pop_front() noexcept
     requires std::is_move_constructible_v<T>
   {
@@ -108,6 +153,16 @@ public:
     return value;
   }
 
+  // Erase front element without returning it (for non-movable types)
+  // O(1)
+  result<> erase_front() noexcept {
+    fail(is_empty(), "list empty");
+
+    deallocate_node(_list.pop_front());
+
+    return {};
+  }
+
   // O(n) - must traverse to find node before tail
   result<T> pop_back() noexcept
     requires std::is_move_constructible_v<T>
@@ -132,6 +187,47 @@ public:
     return {};
   }
 
+  // Unlink the front node without destroying it, so the caller can recycle
+  // it with insert_back() or free it with destroy_node(). O(1)
+  node_pointer extract_front() noexcept {
+    fatal(is_empty(), "extract_front() called on empty list");
+    return _list.pop_front();
+  }
+
+  // Unlink the back node without destroying it.
+  // O(n) - must traverse to find node before tail
+  node_pointer extract_back() noexcept {
+    fatal(is_empty(), "extract_back() called on empty list");
+    return _list.pop_back();
+  }
+
+  // Unlink the node linked after pos without destroying it. O(1), for
+  // callers that keep track of a node's predecessor
+  node_pointer extract_after(node_pointer pos) noexcept {
+    fatal(pos == nullptr || pos->next == nullptr,
+          "extract_after() called without a following node");
+    return _list.erase_after(typename list_type::iterator(pos));
+  }
+
+  node_pointer front_node() const noexcept { return _list.front(); }
+  node_pointer back_node() const noexcept { return _list.back(); }
+
+  // Link a node obtained from extract_front() after the tail. O(1)
+  void insert_back(node_pointer node) noexcept { _list.push_back(node); }
+
+  // Link an extracted node before the head. O(1)
+  void insert_front(node_pointer node) noexcept { _list.push_front(node); }
+
+  static void destroy_node(node_pointer node) noexcept {
+    deallocate_node(node);
+  }
+
+  // Move all of other's nodes after the tail, without reallocating them.
+  // Both lists share the type's allocator. O(1)
+  void splice_back(offset_list &other) noexcept {
+    _list.splice_back(other._list);
+  }
+
   result<const T *> front() const noexcept {
     fail(is_empty(), "list empty");
     return &_list.front()->value;
@@ -155,6 +251,10 @@ public:
     return iterator(this, _list.begin(), false);
   }
   iterator end() const noexcept { return iterator(this, _list.end(), false); }
+  // Iterator to the tail node, end() if empty
+  iterator last() const noexcept {
+    return iterator(this, typename list_type::iterator(_list.back()), false);
+  }
   // cbefore_begin, cbegin, cend provided by container_iterator_interface
   iterator insert_after(iterator pos, auto &&value) noexcept
     requires std::constructible_from<T, decltype(value)>;
@@ -167,7 +267,7 @@ template <is_nothrow T, is_homogenous allocator_type>
 struct offset_list<T, allocator_type>::iterator
     : public forward_iterator_facade<T> {
   friend class offset_list;
-  using intrusive_iterator = typename intrusive_slist<node_pointer>::iterator;
+  using intrusive_iterator = typename list_type::iterator;
   const offset_list *_list{nullptr};
   intrusive_iterator _intrusive_it{nullptr};
   bool _is_before_begin{false};
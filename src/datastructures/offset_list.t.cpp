@@ -117,6 +117,110 @@ TEST_F(OffsetListTest, EmplaceFrontConstructsInPlace) {
   EXPECT_EQ(*list.front().value(), 42);
 }
 
+TEST_F(OffsetListTest, PushBackMaintainsFIFOOrder) {
+  list.push_back(1);
+  list.push_back(2);
+  list.push_back(3);
+
+  EXPECT_EQ(list.size(), 3);
+  EXPECT_EQ(*list.front().value(), 1);
+  EXPECT_EQ(*list.back().value(), 3);
+  EXPECT_EQ(list.pop_front().value(), 1);
+  EXPECT_EQ(list.pop_front().value(), 2);
+  EXPECT_EQ(list.pop_front().value(), 3);
+}
+
+TEST_F(OffsetListTest, EmplaceBackConstructsInPlace) {
+  list.push_front(1);
+  auto result = list.emplace_back(42);
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(list.size(), 2);
+  EXPECT_EQ(*list.back().value(), 42);
+}
+
+TEST_F(OffsetListTest, EraseFrontRemovesFirst) {
+  list.push_back(1);
+  list.push_back(2);
+
+  ASSERT_TRUE(list.erase_front().has_value());
+  EXPECT_EQ(list.size(), 1);
+  EXPECT_EQ(*list.front().value(), 2);
+  EXPECT_EQ(*list.back().value(), 2);
+
+  ASSERT_TRUE(list.erase_front().has_value());
+  EXPECT_TRUE(list.is_empty());
+  EXPECT_FALSE(list.erase_front().has_value());
+}
+
+TEST_F(OffsetListTest, SpliceBackRelinksOtherList) {
+  test_list other{&allocator};
+  list.push_back(1);
+  other.push_back(2);
+  other.push_back(3);
+
+  list.splice_back(other);
+
+  EXPECT_TRUE(other.is_empty());
+  EXPECT_EQ(list.size(), 3);
+  EXPECT_EQ(*list.back().value(), 3);
+  EXPECT_EQ(list.pop_front().value(), 1);
+  EXPECT_EQ(list.pop_front().value(), 2);
+  EXPECT_EQ(list.pop_front().value(), 3);
+}
+
+TEST_F(OffsetListTest, SpliceBackIntoEmptyList) {
+  test_list other{&allocator};
+  other.push_back(1);
+
+  list.splice_back(other);
+  EXPECT_EQ(*list.front().value(), 1);
+  EXPECT_EQ(*list.back().value(), 1);
+
+  // Splicing an empty list keeps the tail
+  list.splice_back(other);
+  list.push_back(2);
+  EXPECT_EQ(list.size(), 2);
+  EXPECT_EQ(*list.back().value(), 2);
+}
+
+TEST_F(OffsetListTest, MoveConstructionKeepsNodes) {
+  list.push_back(1);
+  list.push_back(2);
+  const int *front = list.front().value();
+
+  test_list moved(std::move(list));
+
+  EXPECT_TRUE(list.is_empty());
+  EXPECT_EQ(moved.size(), 2);
+  EXPECT_EQ(moved.front().value(), front);
+}
+
+TEST_F(OffsetListTest, MoveAssignmentReplacesNodes) {
+  test_list other{&allocator};
+  other.push_back(3);
+  list.push_back(1);
+
+  list = std::move(other);
+
+  EXPECT_TRUE(other.is_empty());
+  EXPECT_EQ(list.size(), 1);
+  EXPECT_EQ(*list.front().value(), 3);
+}
+
+TEST_F(OffsetListTest, SwapExchangesNodes) {
+  test_list other{&allocator};
+  other.push_back(3);
+  other.push_back(4);
+  list.push_back(1);
+
+  list.swap(other);
+
+  EXPECT_EQ(list.size(), 2);
+  EXPECT_EQ(*list.back().value(), 4);
+  EXPECT_EQ(other.size(), 1);
+  EXPECT_EQ(*other.front().value(), 1);
+}
+
 TEST_F(OffsetListTest, ClearEmptiesList) {
   list.push_front(1);
   list.push_front(2);
@@ -0,0 +1,367 @@
+#include <algorithm>
+#include <allocators/test_allocator.h>
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <iterators/segmented_algorithms.h>
+#include <queue.h>
+#include <tiered_queue.h>
+#include <vector>
+
+// ============================================================================
+// Allocator Configuration
+// ============================================================================
+// Heap-backed allocator with enough headroom for very deep queues, so the
+// benchmarks measure the queue itself rather than the limits of the compact
+// allocators.
+// ============================================================================
+
+struct deep_allocator : simple_test_allocator {
+  static constexpr size_t max_block_count = 1 << 16;
+  static constexpr size_t total_size = block_size * max_block_count;
+};
+
+// Same, with 1 KiB blocks for the large tier of a tiered_queue
+struct wide_allocator : deep_allocator {
+  static constexpr size_t block_size = 1024;
+  static constexpr size_t total_size = block_size * max_block_count;
+
+  result<pointer_type> allocate_block() noexcept {
+    try {
+      void *mem = ::operator new(block_size, std::align_val_t(block_align));
+      return pointer_type(mem);
+    } catch (...) { return error::out_of_memory; }
+  }
+
+  result<> deallocate_block(pointer_type ptr) noexcept {
+    if (ptr) {
+      ::operator delete(static_cast<void *>(ptr.ptr),
+                        std::align_val_t(block_align));
+    }
+    return {};
+  }
+};
+
+constexpr size_t ring_buffer_capacity = 16;
+constexpr size_t wide_ring_buffer_capacity = 256;
+
+using deep_queue =
+    queue<int, ring_buffer_capacity, deep_allocator, deep_allocator>;
+using counted_deep_queue = queue<int, ring_buffer_capacity, deep_allocator,
+                                 deep_allocator, uint32_t>;
+using spare_deep_queue = queue<int, ring_buffer_capacity, deep_allocator,
+                               deep_allocator, void, 2>;
+using wide_deep_queue =
+    queue<int, wide_ring_buffer_capacity, wide_allocator, deep_allocator>;
+using tiered_deep_queue = tiered_queue<deep_queue, wide_deep_queue>;
+using deep_byte_queue = queue<unsigned char, deep_allocator::block_size,
+                              deep_allocator, deep_allocator>;
+
+static void fill(auto &q, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    q.push(static_cast<int>(i));
+  }
+}
+
+// ============================================================================
+// Dequeue Across Ring Buffer Boundaries
+// ============================================================================
+// Each iteration drains one full ring_buffer (freeing it) and refills one
+// (allocating it), keeping range(0) buffers queued. Time per item should stay
+// flat as the chain grows.
+// ============================================================================
+
+static void BM_PopAcrossBufferBoundary(benchmark::State &state) {
+  deep_allocator local_alloc;
+  deep_allocator list_alloc;
+  deep_queue q(&local_alloc, &list_alloc);
+
+  fill(q, static_cast<size_t>(state.range(0)) * ring_buffer_capacity);
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < ring_buffer_capacity; ++i) {
+      benchmark::DoNotOptimize(q.pop());
+    }
+    fill(q, ring_buffer_capacity);
+  }
+
+  state.SetItemsProcessed(state.iterations() * ring_buffer_capacity);
+}
+BENCHMARK(BM_PopAcrossBufferBoundary)->RangeMultiplier(10)->Range(1, 10000);
+
+// Same from the back: pop_back() drains the newest ring_buffer, and freeing
+// it must not walk the range(0) buffers in front of it.
+static void BM_PopBackAcrossBufferBoundary(benchmark::State &state) {
+  deep_allocator local_alloc;
+  deep_allocator list_alloc;
+  deep_queue q(&local_alloc, &list_alloc);
+
+  fill(q, static_cast<size_t>(state.range(0)) * ring_buffer_capacity);
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < ring_buffer_capacity; ++i) {
+      benchmark::DoNotOptimize(q.pop_back());
+    }
+    fill(q, ring_buffer_capacity);
+  }
+
+  state.SetItemsProcessed(state.iterations() * ring_buffer_capacity);
+}
+BENCHMARK(BM_PopBackAcrossBufferBoundary)
+    ->RangeMultiplier(10)
+    ->Range(1, 10000);
+
+// ============================================================================
+// Oscillating Around a Ring Buffer Boundary
+// ============================================================================
+// A queue that keeps draining and refilling a few elements crosses a boundary
+// on every burst. Without spares each crossing frees a ring_buffer and the
+// next push allocates it again; with spares the emptied one is reused.
+// range(0) is the burst size: 1, a full ring_buffer, one past it.
+// ============================================================================
+
+template <typename queue_type>
+static void BM_BoundaryOscillation(benchmark::State &state) {
+  deep_allocator local_alloc;
+  deep_allocator list_alloc;
+  queue_type q(&local_alloc, &list_alloc);
+  auto burst = static_cast<size_t>(state.range(0));
+
+  for (auto _ : state) {
+    fill(q, burst);
+    for (size_t i = 0; i < burst; ++i) {
+      benchmark::DoNotOptimize(q.pop());
+    }
+  }
+
+  queue_type::shrink_to_fit();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_BoundaryOscillation, deep_queue)
+    ->Arg(1)
+    ->Arg(ring_buffer_capacity)
+    ->Arg(ring_buffer_capacity + 1);
+BENCHMARK_TEMPLATE(BM_BoundaryOscillation, spare_deep_queue)
+    ->Arg(1)
+    ->Arg(ring_buffer_capacity)
+    ->Arg(ring_buffer_capacity + 1);
+
+// ============================================================================
+// Deep Backlog - Fixed vs Tiered Ring Buffer Sizes
+// ============================================================================
+// Builds a backlog of range(0) elements and drains it again. With fixed
+// 16-slot ring_buffers a deep backlog is hundreds of nodes, allocations and
+// pointer hops; the tiered queue moves to 256-slot ring_buffers after four
+// small ones.
+// ============================================================================
+
+static void drain_backlog(benchmark::State &state, auto &q) {
+  auto count = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    fill(q, count);
+    benchmark::DoNotOptimize(q.size());
+    for (size_t i = 0; i < count; ++i) {
+      benchmark::DoNotOptimize(q.pop());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_DeepBacklogFixed(benchmark::State &state) {
+  deep_allocator local_alloc;
+  deep_allocator list_alloc;
+  deep_queue q(&local_alloc, &list_alloc);
+  drain_backlog(state, q);
+}
+BENCHMARK(BM_DeepBacklogFixed)->RangeMultiplier(10)->Range(10, 100000);
+
+static void BM_DeepBacklogTiered(benchmark::State &state) {
+  deep_allocator local_alloc;
+  deep_allocator list_alloc;
+  wide_allocator wide_alloc;
+  tiered_deep_queue q(&local_alloc, &list_alloc, &wide_alloc, &list_alloc);
+  drain_backlog(state, q);
+}
+BENCHMARK(BM_DeepBacklogTiered)->RangeMultiplier(10)->Range(10, 100000);
+
+// ============================================================================
+// Scanning - Element Iterator vs Segmented Algorithm
+// ============================================================================
+// Counts matches over a queue of range(0) elements, once stepping the
+// element iterator and once chunk by chunk over raw pointers.
+// ============================================================================
+
+static void BM_CountElementwise(benchmark::State &state) {
+  deep_allocator local_alloc;
+  deep_allocator list_alloc;
+  deep_queue q(&local_alloc, &list_alloc);
+  fill(q, static_cast<size_t>(state.range(0)));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(std::count(q.begin(), q.end(), 7));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CountElementwise)->RangeMultiplier(8)->Range(64, 64 << 10);
+
+static void BM_CountSegmented(benchmark::State &state) {
+  deep_allocator local_alloc;
+  deep_allocator list_alloc;
+  deep_queue q(&local_alloc, &list_alloc);
+  fill(q, static_cast<size_t>(state.range(0)));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(segmented::count(q, 7));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CountSegmented)->RangeMultiplier(8)->Range(64, 64 << 10);
+
+// ============================================================================
+// size() - Walked vs Counted
+// ============================================================================
+
+template <typename queue_type> static void BM_Size(benchmark::State &state) {
+  deep_allocator local_alloc;
+  deep_allocator list_alloc;
+  queue_type q(&local_alloc, &list_alloc);
+
+  fill(q, static_cast<size_t>(state.range(0)) * ring_buffer_capacity);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(q.size());
+  }
+}
+BENCHMARK_TEMPLATE(BM_Size, deep_queue)->RangeMultiplier(8)->Range(1, 4096);
+BENCHMARK_TEMPLATE(BM_Size, counted_deep_queue)
+    ->RangeMultiplier(8)
+    ->Range(1, 4096);
+
+// ============================================================================
+// Byte Transfer - Per-Element vs Bulk
+// ============================================================================
+
+static void BM_BytesPerElement(benchmark::State &state) {
+  deep_allocator local_alloc;
+  deep_allocator list_alloc;
+  deep_byte_queue q(&local_alloc, &list_alloc);
+  std::vector<unsigned char> bytes(static_cast<size_t>(state.range(0)), 0x5a);
+
+  for (auto _ : state) {
+    for (unsigned char b : bytes) {
+      q.push(b);
+    }
+    for (auto &b : bytes) {
+      b = *q.pop();
+    }
+    benchmark::DoNotOptimize(bytes.data());
+  }
+
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BytesPerElement)->RangeMultiplier(8)->Range(64, 64 << 10);
+
+static void BM_BytesBulk(benchmark::State &state) {
+  deep_allocator local_alloc;
+  deep_allocator list_alloc;
+  deep_byte_queue q(&local_alloc, &list_alloc);
+  std::vector<unsigned char> bytes(static_cast<size_t>(state.range(0)), 0x5a);
+
+  for (auto _ : state) {
+    q.push_range(bytes);
+    benchmark::DoNotOptimize(q.pop_n(bytes));
+    benchmark::DoNotOptimize(bytes.data());
+  }
+
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BytesBulk)->RangeMultiplier(8)->Range(64, 64 << 10);
+
+// ============================================================================
+// Line Framing - Per-Byte Scan vs memchr
+// ============================================================================
+// Splits range(0) bytes of 63-byte lines plus '\n' back into lines.
+// ============================================================================
+
+static std::vector<unsigned char> make_lines(size_t size) {
+  std::vector<unsigned char> bytes(size, 'x');
+  for (size_t i = 63; i < size; i += 64) {
+    bytes[i] = '\n';
+  }
+  return bytes;
+}
+
+static void BM_LinesPerByte(benchmark::State &state) {
+  deep_allocator local_alloc;
+  deep_allocator list_alloc;
+  deep_byte_queue q(&local_alloc, &list_alloc);
+  auto bytes = make_lines(static_cast<size_t>(state.range(0)));
+  std::vector<unsigned char> line(64);
+
+  for (auto _ : state) {
+    q.push_range(bytes);
+    size_t length = 0;
+    while (!q.empty()) {
+      line[length] = *q.pop();
+      length = line[length] == '\n' ? 0 : length + 1;
+    }
+    benchmark::DoNotOptimize(line.data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LinesPerByte)->RangeMultiplier(8)->Range(1 << 10, 64 << 10);
+
+static void BM_LinesReadUntil(benchmark::State &state) {
+  deep_allocator local_alloc;
+  deep_allocator list_alloc;
+  deep_byte_queue q(&local_alloc, &list_alloc);
+  auto bytes = make_lines(static_cast<size_t>(state.range(0)));
+  std::vector<unsigned char> line(64);
+
+  for (auto _ : state) {
+    q.push_range(bytes);
+    while (q.read_until('\n', line)) {}
+    benchmark::DoNotOptimize(line.data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LinesReadUntil)->RangeMultiplier(8)->Range(1 << 10, 64 << 10);
+
+// ============================================================================
+// Restore - Push Loop vs Snapshot
+// ============================================================================
+// Rebuilds a queue of range(0) elements, once pushing them one by one and
+// once from a serialize() image.
+// ============================================================================
+
+static void BM_RestorePushLoop(benchmark::State &state) {
+  deep_allocator local_alloc;
+  deep_allocator list_alloc;
+  std::vector<int> values(static_cast<size_t>(state.range(0)), 7);
+
+  for (auto _ : state) {
+    deep_queue q(&local_alloc, &list_alloc);
+    for (int value : values) {
+      q.push(value);
+    }
+    benchmark::DoNotOptimize(q);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RestorePushLoop)->RangeMultiplier(8)->Range(64, 64 << 10);
+
+static void BM_RestoreSnapshot(benchmark::State &state) {
+  deep_allocator local_alloc;
+  deep_allocator list_alloc;
+  deep_queue source(&local_alloc, &list_alloc);
+  fill(source, static_cast<size_t>(state.range(0)));
+  std::vector<std::byte> image(source.serialized_size());
+  source.serialize(image);
+
+  for (auto _ : state) {
+    deep_queue q(&local_alloc, &list_alloc);
+    q.deserialize(image);
+    benchmark::DoNotOptimize(q);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RestoreSnapshot)->RangeMultiplier(8)->Range(64, 64 << 10);
@@ -1,32 +1,165 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
 #include <offset_list.h>
+#include <span>
+#include <utility>
 #include <result/result.h>
 #include <ring_buffer.h>
 #include <types.h>
 
-template <typename local_buffer_type, typename dynamic_buffer_type>
+template <typename local_buffer_type, typename dynamic_buffer_type,
+          bool = per_thread_allocator<local_buffer_type> ||
+                 per_thread_allocator<dynamic_buffer_type>>
 struct queue_allocator_storage {
   inline static local_buffer_type *_local_alloc{nullptr};
   inline static dynamic_buffer_type *_list_alloc{nullptr};
 };
 
+// With per_thread allocators each thread's queues use that thread's arenas
+template <typename local_buffer_type, typename dynamic_buffer_type>
+struct queue_allocator_storage<local_buffer_type, dynamic_buffer_type, true> {
+  inline static thread_local local_buffer_type *_local_alloc{nullptr};
+  inline static thread_local dynamic_buffer_type *_list_alloc{nullptr};
+};
+
+// Placeholder for queues that don't maintain an element counter, takes no
+// space thanks to [[no_unique_address]]
+struct no_size_counter {};
+
+template <typename T>
+concept size_counter = std::is_void_v<T> || (std::unsigned_integral<T> &&
+                                              !std::same_as<T, bool>);
+
+// Elements a byte queue can hold: scanned with memchr, copied with memcpy
+template <typename T>
+concept byte_like = sizeof(T) == 1 && std::is_trivially_copyable_v<T>;
+
+// Emptied ring_buffer nodes kept for reuse. Like the allocators they are
+// shared by all queues of one type (of one thread, with per_thread
+// allocators), so retaining them costs no space in the queue itself. The
+// spares are handed back when the last constructed queue is destroyed, so
+// they never outlive the allocators they came from.
+template <typename node_pointer, size_t capacity, bool per_thread_context>
+struct queue_spare_storage {
+  inline static intrusive_slist<node_pointer, capacity> _spares;
+  inline static size_t _live_queues{0};
+};
+
+template <typename node_pointer, size_t capacity>
+struct queue_spare_storage<node_pointer, capacity, true> {
+  inline static thread_local intrusive_slist<node_pointer, capacity> _spares;
+  inline static thread_local size_t _live_queues{0};
+};
+
+// Where the last queue::compact() call stopped, so the next call resumes
+// there instead of walking the list from the front again. Shared by all
+// queues of one type, so compacting another queue restarts the pass.
+template <typename node_pointer, bool per_thread_context>
+struct queue_compact_storage {
+  inline static const void *_queue{nullptr};
+  inline static node_pointer _resume{nullptr};
+};
+
+template <typename node_pointer>
+struct queue_compact_storage<node_pointer, true> {
+  inline static thread_local const void *_queue{nullptr};
+  inline static thread_local node_pointer _resume{nullptr};
+};
+
+// Flow control for queues sharing one arena, set per queue type with
+// queue::set_limits(). Growing a queue past a limit fails with
+// error::backpressure, so a runaway queue is pushed back before the arena
+// runs into its OOM callback. A zero disables the limit.
+struct queue_limits {
+  // Ring_buffers one queue may hold, each costs a local block and a list node
+  size_t max_ring_buffers = 0;
+  // Free local blocks held back for small queues: once the arena is down to
+  // reserve_blocks, only queues holding fewer than small_queue_ring_buffers
+  // ring_buffers may grow
+  size_t reserve_blocks = 0;
+  size_t small_queue_ring_buffers = 1;
+  // on_high runs when high_watermark local blocks are in use, on_low when
+  // usage falls back to low_watermark. They run inside the queue operation
+  // that crossed the mark, and must not modify queues of this type.
+  size_t high_watermark = 0;
+  size_t low_watermark = 0;
+  std::function<void()> on_high{nullptr};
+  std::function<void()> on_low{nullptr};
+};
+
+// Limits and watermark state, shared by all queues of one type like the
+// allocators
+template <typename queue_type, bool per_thread_context>
+struct queue_flow_storage {
+  inline static queue_limits _limits{};
+  inline static bool _above_high{false};
+};
+
+template <typename queue_type>
+struct queue_flow_storage<queue_type, true> {
+  inline static thread_local queue_limits _limits{};
+  inline static thread_local bool _above_high{false};
+};
+
 // FIFO queue implemented as a linked list of ring buffers.
+// size_counter_type = void computes size() by walking the ring buffers,
+// an unsigned integer type maintains an O(1) counter of that width instead.
+// spare_ring_buffers > 0 keeps up to that many emptied ring_buffers (node and
+// storage) per queue type for reuse, instead of freeing and reallocating them
+// whenever the queue crosses a ring_buffer boundary.
 template <is_nothrow T, size_t ring_buffer_capacity,
-          is_homogenous local_buffer_type, is_homogenous dynamic_buffer_type>
+          is_homogenous local_buffer_type, is_homogenous dynamic_buffer_type,
+          size_counter size_counter_type = void, size_t spare_ring_buffers = 0>
 class queue {
 public:
+  using value_type = T;
   using ring_buffer_type =
       ring_buffer<T, ring_buffer_capacity, local_buffer_type>;
   using storage =
       queue_allocator_storage<local_buffer_type, dynamic_buffer_type>;
 
+  static constexpr bool counts_size = !std::is_void_v<size_counter_type>;
+  static constexpr size_t spare_capacity_v = spare_ring_buffers;
+
 private:
+  // A list node can't name its own pointer type here, so the back link is
+  // a plain block pointer of the list allocator
+  using back_pointer = typename dynamic_buffer_type::pointer_type;
+
   struct ring_buffer_node {
     ring_buffer_type buffer;
+    // The node linked before this one. Valid for every node but the oldest,
+    // so the newest ring_buffer is unlinked without walking the list.
+    back_pointer prev{nullptr};
     explicit ring_buffer_node(local_buffer_type *alloc) : buffer(alloc) {}
   };
 
-  offset_list<ring_buffer_node, dynamic_buffer_type> _list;
+  using list_type = offset_list<ring_buffer_node, dynamic_buffer_type>;
+  using node_pointer = typename list_type::node_pointer;
+  using spare_storage =
+      queue_spare_storage<typename list_type::node_pointer,
+                          spare_ring_buffers,
+                          per_thread_allocator<local_buffer_type> ||
+                              per_thread_allocator<dynamic_buffer_type>>;
+  using flow_storage =
+      queue_flow_storage<queue, per_thread_allocator<local_buffer_type> ||
+                                    per_thread_allocator<dynamic_buffer_type>>;
+  using compact_storage =
+      queue_compact_storage<node_pointer,
+                            per_thread_allocator<local_buffer_type> ||
+                                per_thread_allocator<dynamic_buffer_type>>;
+
+  using counter_type = std::conditional_t<counts_size, size_counter_type,
+                                          no_size_counter>;
+
+  list_type _list;
+  [[no_unique_address]] counter_type _count{};
 
 public:
   static_assert(sizeof(ring_buffer_node) <= dynamic_buffer_type::block_size,
@@ -38,19 +171,38 @@ public:
   static_assert(ring_buffer_type::storage_bytes_v <=
                     local_buffer_type::block_size,
                 "LocalBuffer block_size too small for ring_buffer storage");
+  // The spare list counts in smallest_t<spare_ring_buffers>, which holds
+  // values below spare_ring_buffers only. At a power-of-two boundary (256,
+  // 65536) a full list would wrap its count to 0 and the capacity checks
+  // would never fail again.
+  static_assert(spare_ring_buffers <=
+                    std::numeric_limits<smallest_t<spare_ring_buffers>>::max(),
+                "spare_ring_buffers must fit the spare list's counter");
 
   explicit queue(local_buffer_type *local_alloc,
                  dynamic_buffer_type *list_alloc)
-      : _list(list_alloc) {
-    fatal(local_alloc == nullptr, "Local allocator cannot be null");
-    fatal(list_alloc == nullptr, "List allocator cannot be null");
+      : _list(adopt_allocators(local_alloc, list_alloc)) {
+    if constexpr (spare_ring_buffers > 0) { ++spare_storage::_live_queues; }
+  }
 
-    storage::_local_alloc = local_alloc;
-    storage::_list_alloc = list_alloc;
+  // Set the allocators shared by queues of this type without constructing
+  // one. Queue objects kept in a file-backed arena (mapped_buffer) are
+  // recovered as they are, without running a constructor, and are usable
+  // once their type is attached to the reopened allocators.
+  static void attach(local_buffer_type *local_alloc,
+                     dynamic_buffer_type *list_alloc) noexcept {
+    list_type::attach(adopt_allocators(local_alloc, list_alloc));
+    ring_buffer_type::attach(local_alloc);
   }
 
   ~queue() {
     clear();
+    // Recovered queues are destroyed without having been constructed, so the
+    // count only ever errs towards releasing the spares early
+    if constexpr (spare_ring_buffers > 0) {
+      if (spare_storage::_live_queues > 0) { --spare_storage::_live_queues; }
+      if (spare_storage::_live_queues == 0) { shrink_to_fit(); }
+    }
     // NOTE: Don't clear static storage here when using multiple instances.
     // All instances of the same queue type share static storage, so clearing
     // it would break other instances. The storage is overwritten on
@@ -61,62 +213,582 @@ public:
 
   queue(const queue &) = delete;
   queue &operator=(const queue &) = delete;
-  queue(queue &&) = delete;
-  queue &operator=(queue &&) = delete;
+
+  // Queues of one type share their allocators, so moving hands over the
+  // ring_buffer chain without allocating or copying elements. The moved-from
+  // queue is empty and usable.
+  queue(queue &&other) noexcept
+      : _list(std::move(other._list)),
+        _count(std::exchange(other._count, counter_type{})) {
+    forget_compaction(&other);
+    if constexpr (spare_ring_buffers > 0) { ++spare_storage::_live_queues; }
+  }
+
+  // Destroys this queue's elements, then takes other's
+  queue &operator=(queue &&other) noexcept {
+    if (this != &other) {
+      clear();
+      forget_compaction(&other);
+      _list = std::move(other._list);
+      _count = std::exchange(other._count, counter_type{});
+    }
+    return *this;
+  }
+
+  void swap(queue &other) noexcept {
+    forget_compaction(this);
+    forget_compaction(&other);
+    _list.swap(other._list);
+    std::swap(_count, other._count);
+  }
 
   template <typename U>
     requires std::constructible_from<T, U>
   result<> push(U &&value) noexcept {
+    if constexpr (counts_size) {
+      fail(_count == std::numeric_limits<size_counter_type>::max(),
+           "queue size counter overflow");
+    }
+
     if (_list.is_empty() ||
-        const_cast<ring_buffer_node *>(ok(_list.front()))->buffer.is_full()) {
+        const_cast<ring_buffer_node *>(ok(_list.back()))->buffer.is_full()) {
       ok(allocate_new_ring_buffer());
     }
 
-    const_cast<ring_buffer_node *>(ok(_list.front()))
+    const_cast<ring_buffer_node *>(ok(_list.back()))
         ->buffer.push(std::forward<U>(value));
+    if constexpr (counts_size) { ++_count; }
     return {};
   }
 
   template <typename... Args>
     requires std::constructible_from<T, Args...>
   result<> emplace(Args &&...args) noexcept {
+    if constexpr (counts_size) {
+      fail(_count == std::numeric_limits<size_counter_type>::max(),
+           "queue size counter overflow");
+    }
+
     if (_list.is_empty() ||
-        const_cast<ring_buffer_node *>(ok(_list.front()))->buffer.is_full()) {
+        const_cast<ring_buffer_node *>(ok(_list.back()))->buffer.is_full()) {
       ok(allocate_new_ring_buffer());
     }
 
-    const_cast<ring_buffer_node *>(ok(_list.front()))
+    const_cast<ring_buffer_node *>(ok(_list.back()))
         ->buffer.emplace(std::forward<Args>(args)...);
+    if constexpr (counts_size) { ++_count; }
     return {};
   }
 
   result<T> pop() noexcept {
     fail(empty(), "Cannot pop from empty queue");
 
-    auto *pop_node = const_cast<ring_buffer_node *>(ok(_list.back()));
+    auto *pop_node = const_cast<ring_buffer_node *>(ok(_list.front()));
     T value = ok(pop_node->buffer.pop());
+    if constexpr (counts_size) { --_count; }
+
+    if (pop_node->buffer.empty()) { deallocate_front_ring_buffer(); }
+
+    return value;
+  }
+
+  // ==========================================================================
+  // Double-Ended Operations
+  // ==========================================================================
+  // The oldest ring_buffer grows backwards from its head, and a new one is
+  // linked before it when it is full, so pushing to the front is O(1) like
+  // push(). pop_back() is O(1) as well: when it empties the newest
+  // ring_buffer, the node's back link finds its predecessor.
+
+  // Insert value before the oldest element, so it is popped next
+  template <typename U>
+    requires std::constructible_from<T, U>
+  result<> push_front(U &&value) noexcept {
+    return emplace_front(std::forward<U>(value));
+  }
+
+  template <typename... Args>
+    requires std::constructible_from<T, Args...>
+  result<> emplace_front(Args &&...args) noexcept {
+    if constexpr (counts_size) {
+      fail(_count == std::numeric_limits<size_counter_type>::max(),
+           "queue size counter overflow");
+    }
+
+    if (_list.is_empty() ||
+        const_cast<ring_buffer_node *>(ok(_list.front()))->buffer.is_full()) {
+      ok(allocate_front_ring_buffer());
+    }
+
+    const_cast<ring_buffer_node *>(ok(_list.front()))
+        ->buffer.emplace_front(std::forward<Args>(args)...);
+    if constexpr (counts_size) { ++_count; }
+    return {};
+  }
+
+  // Remove and return the newest element
+  result<T> pop_back() noexcept {
+    fail(empty(), "Cannot pop_back from empty queue");
+
+    auto *pop_node = const_cast<ring_buffer_node *>(ok(_list.back()));
+    T value = ok(pop_node->buffer.pop_back());
+    if constexpr (counts_size) { --_count; }
 
     if (pop_node->buffer.empty()) { deallocate_back_ring_buffer(); }
 
     return value;
   }
 
-  void clear() noexcept { _list.clear(); }
+  // Push all values, copying whole contiguous runs into each ring_buffer.
+  // If a ring_buffer allocation fails, the values pushed so far stay queued.
+  result<> push_range(std::span<const T> values) noexcept
+    requires std::copy_constructible<T>
+  {
+    if constexpr (counts_size) {
+      fail(values.size() >
+               std::numeric_limits<size_counter_type>::max() - _count,
+           "queue size counter overflow");
+    }
+
+    ring_buffer_node *node = nullptr;
+    if (!_list.is_empty()) {
+      node = const_cast<ring_buffer_node *>(ok(_list.back()));
+    }
+
+    while (!values.empty()) {
+      if (node == nullptr || node->buffer.is_full()) {
+        ok(allocate_new_ring_buffer());
+        node = const_cast<ring_buffer_node *>(ok(_list.back()));
+      }
+
+      auto pushed = node->buffer.push_range(values);
+      values = values.subspan(pushed);
+      if constexpr (counts_size) { _count += pushed; }
+    }
+    return {};
+  }
+
+  // Pop up to out.size() elements into out, moving whole contiguous runs out
+  // of each ring_buffer. Returns the number of elements popped.
+  result<size_t> pop_n(std::span<T> out) noexcept {
+    size_t popped = 0;
+    while (popped < out.size() && !_list.is_empty()) {
+      auto *pop_node = const_cast<ring_buffer_node *>(ok(_list.front()));
+      popped += pop_node->buffer.pop_n(out.subspan(popped));
+
+      if (pop_node->buffer.empty()) { ok(deallocate_front_ring_buffer()); }
+    }
+
+    if constexpr (counts_size) { _count -= popped; }
+    return popped;
+  }
+
+  // Oldest contiguous chunk of readable data, without copying it out
+  result<std::span<const T>> peek() const noexcept {
+    fail(empty(), "peek() called on empty queue");
+    return ok(_list.front())->buffer.read_spans()[0];
+  }
+
+  // Discard the n oldest elements in place, releasing emptied ring_buffers.
+  // Fails if the queue runs out first, elements discarded until then stay
+  // discarded.
+  result<> consume(size_t n) noexcept {
+    while (n > 0) {
+      fail(_list.is_empty(), "Cannot consume past the end of queue");
+
+      auto *pop_node = const_cast<ring_buffer_node *>(ok(_list.front()));
+      auto count = static_cast<typename ring_buffer_type::size_type>(
+          std::min<size_t>(n, pop_node->buffer.size()));
+      pop_node->buffer.consume(count);
+      n -= count;
+      if constexpr (counts_size) { _count -= count; }
+
+      if (pop_node->buffer.empty()) { ok(deallocate_front_ring_buffer()); }
+    }
+    return {};
+  }
+
+  // ==========================================================================
+  // Byte Queues - Delimiters and Records
+  // ==========================================================================
+  // Records are a little-endian record_length_type payload length followed
+  // by the payload. Incomplete data (no delimiter, partial record) is the
+  // normal state of a stream, so those failures are not logged and leave the
+  // queue untouched.
+
+  using record_length_type = uint32_t;
+  static constexpr size_t record_header_size = sizeof(record_length_type);
+
+  // Index of the first element equal to value, one memchr per chunk
+  result<size_t> find(T value) const noexcept
+    requires byte_like<T>
+  {
+    size_t index = 0;
+    const T *hit = nullptr;
+    for (auto chunk : read_chunks()) {
+      hit = static_cast<const T *>(std::memchr(
+          chunk.data(), static_cast<unsigned char>(value), chunk.size()));
+      if (hit != nullptr) {
+        index += static_cast<size_t>(hit - chunk.data());
+        break;
+      }
+      index += chunk.size();
+    }
+    fail(hit == nullptr, "value not in queue").silent();
+    return index;
+  }
+
+  // Pop everything up to and including the first delim into out and return
+  // that length. Fails without popping if no delim is queued or the line
+  // doesn't fit out.
+  result<size_t> read_until(T delim, std::span<T> out) noexcept
+    requires byte_like<T>
+  {
+    size_t length = ok(find(delim)) + 1;
+    fail(length > out.size(), "read_until output too small for line");
+    return pop_n(out.first(length));
+  }
+
+  // Append a length-prefixed record. Either the whole record is queued or,
+  // if ring_buffer allocation fails, nothing is.
+  result<> write_record(std::span<const T> payload) noexcept
+    requires byte_like<T>
+  {
+    fail(payload.size() > std::numeric_limits<record_length_type>::max(),
+         "record payload too long");
+
+    std::array<T, record_header_size> header;
+    for (size_t i = 0; i < header.size(); ++i) {
+      header[i] = static_cast<T>(
+          static_cast<unsigned char>(payload.size() >> (8 * i)));
+    }
+
+    size_t total = header.size() + payload.size();
+    auto reservation = ok(reserve_write(total));
+
+    std::array<std::span<const T>, 2> sources{header, payload};
+    size_t source = 0;
+    for (std::span<T> chunk : reservation) {
+      while (!chunk.empty() && source < sources.size()) {
+        auto n = std::min(chunk.size(), sources[source].size());
+        std::copy_n(sources[source].data(), n, chunk.data());
+        chunk = chunk.subspan(n);
+        sources[source] = sources[source].subspan(n);
+        if (sources[source].empty()) { ++source; }
+      }
+      if (source == sources.size()) { break; }
+    }
+
+    return commit_write(reservation, total);
+  }
+
+  // Pop one record written by write_record() and return its payload length,
+  // with the payload in out. Fails without popping if the record isn't
+  // complete yet or its payload doesn't fit out.
+  result<size_t> read_record(std::span<T> out) noexcept
+    requires byte_like<T>
+  {
+    std::array<T, record_header_size> header;
+    size_t have = 0;
+    for (auto chunk : read_chunks()) {
+      auto n = std::min(chunk.size(), header.size() - have);
+      std::memcpy(header.data() + have, chunk.data(), n);
+      have += n;
+      if (have == header.size()) { break; }
+    }
+    fail(have < header.size(), "record header not complete").silent();
+
+    size_t length = 0;
+    for (size_t i = 0; i < header.size(); ++i) {
+      length |= size_t{static_cast<unsigned char>(header[i])} << (8 * i);
+    }
+    fail(!holds_at_least(header.size() + length), "record not complete")
+        .silent();
+    fail(length > out.size(), "read_record output too small for payload");
+
+    ok(consume(header.size()));
+    return pop_n(out.first(length));
+  }
+
+  // ==========================================================================
+  // Snapshots - Contiguous Byte Images
+  // ==========================================================================
+  // An image is a snapshot_header followed by the elements, oldest first, as
+  // raw bytes. Both are in host byte order, so images are meant to be read
+  // back by the same build on the same machine.
+
+  struct snapshot_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t element_size;
+    uint64_t count;
+  };
+
+  static constexpr uint32_t snapshot_magic = 0x51554555; // "QUEU"
+  static constexpr uint16_t snapshot_version = 1;
+
+  size_t serialized_size() const noexcept
+    requires std::is_trivially_copyable_v<T>
+  {
+    return sizeof(snapshot_header) + size() * sizeof(T);
+  }
+
+  // Write the image into out, one memcpy per chunk, and return its length.
+  // The queue is left unchanged.
+  result<size_t> serialize(std::span<std::byte> out) const noexcept
+    requires std::is_trivially_copyable_v<T>
+  {
+    size_t count = size();
+    size_t length = sizeof(snapshot_header) + count * sizeof(T);
+    fail(length > out.size(), "serialize output too small for queue");
+
+    snapshot_header header{snapshot_magic, snapshot_version,
+                           static_cast<uint16_t>(sizeof(T)), count};
+    std::memcpy(out.data(), &header, sizeof(header));
+
+    std::byte *cursor = out.data() + sizeof(header);
+    for (auto chunk : read_chunks()) {
+      std::memcpy(cursor, chunk.data(), chunk.size_bytes());
+      cursor += chunk.size_bytes();
+    }
+    return length;
+  }
+
+  // Replace the queue's elements with those of an image written by
+  // serialize() and return the image's length. All ring_buffers are
+  // allocated in one reserve_write() before any element is copied, so if the
+  // image is invalid or allocation fails the queue is left unchanged.
+  result<size_t> deserialize(std::span<const std::byte> in) noexcept
+    requires std::is_trivially_copyable_v<T>
+  {
+    snapshot_header header;
+    fail(in.size() < sizeof(header), "snapshot shorter than its header");
+    std::memcpy(&header, in.data(), sizeof(header));
+
+    fail(header.magic != snapshot_magic, "not a queue snapshot");
+    fail(header.version != snapshot_version, "unsupported snapshot version");
+    fail(header.element_size != sizeof(T), "snapshot element size mismatch");
+    fail(header.count > (in.size() - sizeof(header)) / sizeof(T),
+         "snapshot truncated");
+    if constexpr (counts_size) {
+      fail(header.count > std::numeric_limits<size_counter_type>::max(),
+           "queue size counter overflow");
+    }
+
+    size_t count = static_cast<size_t>(header.count);
+    queue restored(std::move(*this));
+    if (count > 0) {
+      auto reservation = reserve_write(count);
+      if (!reservation) {
+        *this = std::move(restored);
+        return std::unexpected(reservation.error());
+      }
+
+      const std::byte *cursor = in.data() + sizeof(header);
+      size_t remaining = count;
+      for (std::span<T> chunk : *reservation) {
+        auto n = std::min(chunk.size(), remaining);
+        std::memcpy(chunk.data(), cursor, n * sizeof(T));
+        cursor += n * sizeof(T);
+        remaining -= n;
+        if (remaining == 0) { break; }
+      }
+      ok(commit_write(*reservation, count));
+    }
+    return sizeof(header) + count * sizeof(T);
+  }
+
+  template <bool writable> class basic_chunk_iterator;
+  using chunk_iterator = basic_chunk_iterator<false>;
+  using write_iterator = basic_chunk_iterator<true>;
+
+  template <typename iterator> struct chunk_view {
+    iterator _begin;
+    iterator _end;
+
+    iterator begin() const noexcept { return _begin; }
+    iterator end() const noexcept { return _end; }
+  };
+  using chunk_range = chunk_view<chunk_iterator>;
+
+  // All readable data as contiguous chunks, oldest first, at most two per
+  // ring_buffer. Invalidated by any operation that modifies the queue.
+  chunk_range read_chunks() const noexcept;
+
+  // Read-only element iterator, oldest first. It is a segmented iterator
+  // over read_chunks(), so the segmented:: algorithms in
+  // iterators/segmented_algorithms.h loop over whole chunks instead.
+  // Invalidated by any operation that modifies the queue.
+  class const_iterator;
+  using iterator = const_iterator;
+  const_iterator begin() const noexcept;
+  const_iterator end() const noexcept;
+
+  // Writable free slots handed out by reserve_write(), filled in place and
+  // published by commit_write().
+  struct write_reservation {
+    typename offset_list<ring_buffer_node, dynamic_buffer_type>::iterator
+        anchor; // tail node at reservation time, or before_begin()
+    chunk_view<write_iterator> chunks;
+    size_t capacity; // total slots across chunks, at least the requested n
+
+    write_iterator begin() const noexcept { return chunks.begin(); }
+    write_iterator end() const noexcept { return chunks.end(); }
+  };
+
+  // Reserve at least n free slots at the back, allocating ring_buffers as
+  // needed. Until commit_write() the reserved ring_buffers are linked but
+  // hold no elements, so no other operation may run on the queue meanwhile.
+  // Fails without reserving if n more elements would overflow the counter.
+  result<write_reservation> reserve_write(size_t n) noexcept
+    requires std::is_trivially_copyable_v<T>;
+
+  // Publish the first k reserved slots as elements and release reserved
+  // ring_buffers that stayed empty. commit_write(reservation, 0) abandons
+  // the reservation, and so does a commit that fails: the queue is left as
+  // it was before reserve_write().
+  result<> commit_write(const write_reservation &reservation,
+                        size_t k) noexcept
+    requires std::is_trivially_copyable_v<T>;
+
+  void clear() noexcept {
+    forget_compaction(this);
+    _list.clear();
+    if constexpr (counts_size) { _count = 0; }
+    update_watermarks();
+  }
+
+  // Append all of other's elements, oldest first, and leave other empty.
+  // The ring_buffers are relinked, not copied, as queues of one type share
+  // their allocators. O(1)
+  result<> splice_back(queue &other) noexcept {
+    fail(&other == this, "Cannot splice a queue into itself");
+    if constexpr (counts_size) {
+      fail(other._count > std::numeric_limits<size_counter_type>::max() -
+                              _count,
+           "queue size counter overflow");
+      _count += other._count;
+      other._count = 0;
+    }
+
+    if (!_list.is_empty() && !other._list.is_empty()) {
+      link_prev(other._list.front_node(), _list.back_node());
+    }
+    forget_compaction(&other);
+    _list.splice_back(other._list);
+    return {};
+  }
+
+  // Replace this queue's elements with all of other's and leave other empty.
+  // O(1) besides destroying the elements this queue held.
+  result<> take_all(queue &other) noexcept {
+    fail(&other == this, "Cannot take from the queue itself");
+    clear();
+    return splice_back(other);
+  }
+
+  // Merge neighbouring ring_buffers whose elements fit into one and free the
+  // emptied ones, so a queue left with many sparsely filled ring_buffers
+  // (after bursts, splices or head/tail drift) gives their blocks back.
+  // Each ring_buffer skipped and each element moved costs one unit of
+  // budget, so a call from an idle hook is bounded however long the queue
+  // is. A call resumes where the previous one stopped, and compacting()
+  // stays true until the pass reaches the back. Returns the number of
+  // ring_buffers freed.
+  size_t compact(size_t budget) noexcept {
+    size_t freed = 0;
+    node_pointer into = compact_storage::_queue == this
+                            ? compact_storage::_resume
+                            : _list.front_node();
+    while (budget > 0 && into != nullptr && into->next != nullptr) {
+      node_pointer from = into->next;
+      auto &target = into->value.buffer;
+      auto &source = from->value.buffer;
+      if (target.size() + source.size() > ring_buffer_capacity) {
+        --budget;
+        into = from;
+        continue;
+      }
+
+      // A partial move leaves the rest for the next call to continue
+      size_t moved =
+          target.take_front(source, std::min<size_t>(budget, source.size()));
+      budget -= std::max<size_t>(moved, 1);
+      if (!source.empty()) { break; }
+      // The emptied ring_buffer is freed, not kept as a spare
+      list_type::destroy_node(_list.extract_after(into));
+      if (into->next != nullptr) { link_prev(into->next, into); }
+      ++freed;
+    }
+
+    if (into != nullptr && into->next != nullptr) {
+      compact_storage::_queue = this;
+      compact_storage::_resume = into;
+    } else {
+      forget_compaction(this);
+    }
+    if (freed > 0) { update_watermarks(); }
+    return freed;
+  }
+
+  // Whether a compact() pass over this queue stopped before the back
+  bool compacting() const noexcept { return compact_storage::_queue == this; }
+
+  // Hand the retained spare ring_buffers back to the allocators now, rather
+  // than when the last queue of this type is destroyed
+  static void shrink_to_fit() noexcept {
+    if constexpr (spare_ring_buffers > 0) {
+      while (!spare_storage::_spares.empty()) {
+        list_type::destroy_node(spare_storage::_spares.pop_front());
+      }
+    }
+  }
+
+  static size_t spare_count() noexcept {
+    if constexpr (spare_ring_buffers > 0) {
+      return spare_storage::_spares.size();
+    } else {
+      return 0;
+    }
+  }
+
+  // Apply limits to all queues of this type. Quotas are checked whenever a
+  // queue needs another ring_buffer, so a queue already above its quota
+  // keeps its elements; splice_back() and take_all() are not limited.
+  static void set_limits(queue_limits limits) noexcept {
+    if constexpr (!provides_availability<local_buffer_type>) {
+      fatal(limits.reserve_blocks > 0 || limits.high_watermark > 0,
+            "reserve and watermarks need an allocator reporting free blocks");
+    }
+    fatal(limits.high_watermark > 0 &&
+              limits.low_watermark >= limits.high_watermark,
+          "low watermark must be below the high watermark");
+
+    flow_storage::_limits = std::move(limits);
+    flow_storage::_above_high = false;
+    update_watermarks();
+  }
+
+  static const queue_limits &limits() noexcept {
+    return flow_storage::_limits;
+  }
 
   result<const T *> front() const noexcept {
     fail(empty(), "front() called on empty queue");
-    return &ok(_list.back())->buffer.front();
+    return &ok(_list.front())->buffer.front();
   }
 
   result<const T *> back() const noexcept {
     fail(empty(), "back() called on empty queue");
-    return &ok(_list.front())->buffer.back();
+    return &ok(_list.back())->buffer.back();
   }
 
   bool empty() const noexcept { return _list.is_empty(); }
 
-  // O(n) where n is number of ring_buffers
+  // O(1) with a size counter, otherwise O(n) where n is number of ring_buffers
   size_t size() const noexcept {
+    if constexpr (counts_size) { return _count; }
+
     size_t total = 0;
     int counter = 0;
     // for (const auto &node : _list) {
@@ -133,15 +805,365 @@ public:
   }
 
 private:
+  // Point all queues of this type at the allocators. Spares taken from
+  // other allocators are not linked into queues using these: they go back
+  // to their allocators while queues still use those, and are dropped if
+  // only queues abandoned without destruction (a closed file-backed arena)
+  // could have left them, as their allocators may be gone.
+  static dynamic_buffer_type *
+  adopt_allocators(local_buffer_type *local_alloc,
+                   dynamic_buffer_type *list_alloc) noexcept {
+    fatal(local_alloc == nullptr, "Local allocator cannot be null");
+    fatal(list_alloc == nullptr, "List allocator cannot be null");
+
+    if constexpr (spare_ring_buffers > 0) {
+      if (local_alloc != storage::_local_alloc ||
+          list_alloc != storage::_list_alloc) {
+        if (spare_storage::_live_queues > 0) {
+          shrink_to_fit();
+        } else {
+          spare_storage::_spares.clear();
+        }
+      }
+    }
+
+    storage::_local_alloc = local_alloc;
+    storage::_list_alloc = list_alloc;
+    return list_alloc;
+  }
+
+  // Stops walking once n elements are seen
+  bool holds_at_least(size_t n) const noexcept {
+    if constexpr (counts_size) { return _count >= n; }
+
+    size_t total = 0;
+    for (const auto &node : _list) {
+      total += node.buffer.size();
+      if (total >= n) { return true; }
+    }
+    return total >= n;
+  }
+
+  // Newest ring_buffer is linked at the tail, oldest sits at the head, so both
+  // ends of the queue are reached without walking the list.
   result<> allocate_new_ring_buffer() noexcept {
+    node_pointer tail = _list.back_node();
+    if constexpr (spare_ring_buffers > 0) {
+      if (!spare_storage::_spares.empty()) {
+        ok(admit_ring_buffer(false));
+        _list.insert_back(spare_storage::_spares.pop_front());
+        link_prev(_list.back_node(), tail);
+        return {};
+      }
+    }
+
+    ok(admit_ring_buffer(true));
+    ok(_list.emplace_back(storage::_local_alloc));
+    link_prev(_list.back_node(), tail);
+    update_watermarks();
+    return {};
+  }
+
+  result<> allocate_front_ring_buffer() noexcept {
+    node_pointer head = _list.front_node();
+    if constexpr (spare_ring_buffers > 0) {
+      if (!spare_storage::_spares.empty()) {
+        ok(admit_ring_buffer(false));
+        _list.insert_front(spare_storage::_spares.pop_front());
+        if (head != nullptr) { link_prev(head, _list.front_node()); }
+        return {};
+      }
+    }
+
+    ok(admit_ring_buffer(true));
     ok(_list.emplace_front(storage::_local_alloc));
+    if (head != nullptr) { link_prev(head, _list.front_node()); }
+    update_watermarks();
     return {};
   }
 
+  static void link_prev(node_pointer node, node_pointer prev) noexcept {
+    node->value.prev = back_pointer(static_cast<void *>(prev));
+  }
+
+  static node_pointer prev_of(node_pointer node) noexcept {
+    return node_pointer(static_cast<void *>(node->value.prev));
+  }
+
+  // Refuse another ring_buffer when this queue is at its quota, or when it
+  // is not small and taking blocks from the arena would eat into the
+  // reserve. Spares were allocated already and only count for the quota.
+  result<> admit_ring_buffer(bool from_arena) const noexcept {
+    const auto &limits = flow_storage::_limits;
+    size_t held = _list.size();
+    fail(limits.max_ring_buffers > 0 && held >= limits.max_ring_buffers,
+         error::backpressure)
+        .silent();
+    if constexpr (provides_availability<local_buffer_type>) {
+      fail(from_arena && limits.reserve_blocks > 0 &&
+               held >= limits.small_queue_ring_buffers &&
+               storage::_local_alloc->available() <= limits.reserve_blocks,
+           error::backpressure)
+          .silent();
+    }
+    return {};
+  }
+
+  // Run on_high or on_low when arena usage crossed a watermark
+  static void update_watermarks() noexcept {
+    if constexpr (provides_availability<local_buffer_type>) {
+      const auto &limits = flow_storage::_limits;
+      if (limits.high_watermark == 0 || storage::_local_alloc == nullptr) {
+        return;
+      }
+
+      size_t used = local_buffer_type::max_block_count -
+                    storage::_local_alloc->available();
+      if (!flow_storage::_above_high && used >= limits.high_watermark) {
+        flow_storage::_above_high = true;
+        if (limits.on_high) { limits.on_high(); }
+      } else if (flow_storage::_above_high && used <= limits.low_watermark) {
+        flow_storage::_above_high = false;
+        if (limits.on_low) { limits.on_low(); }
+      }
+    }
+  }
+
+  // O(1) through the newest node's back link
   result<> deallocate_back_ring_buffer() noexcept {
     fail(_list.is_empty(), "Cannot deallocate from empty list");
+    if (_list.size() == 1) { return deallocate_front_ring_buffer(); }
 
-    ok(_list.erase_back());
+    release_ring_buffer(_list.extract_after(prev_of(_list.back_node())));
     return {};
   }
+
+  result<> deallocate_front_ring_buffer() noexcept {
+    fail(_list.is_empty(), "Cannot deallocate from empty list");
+
+    release_ring_buffer(_list.extract_front());
+    return {};
+  }
+
+  // Release the ring_buffers linked after pos, all of them for
+  // before_begin(). Reserved ring_buffers that stay empty are kept as spares
+  // like any other.
+  void release_after(typename list_type::iterator pos) noexcept {
+    if (pos.is_before_begin()) {
+      while (!_list.is_empty()) { release_ring_buffer(_list.extract_front()); }
+      return;
+    }
+
+    node_pointer keep = pos.intrusive().node();
+    while (_list.back_node() != keep) {
+      release_ring_buffer(_list.extract_after(keep));
+    }
+  }
+
+  // Drop the compact() resume point if it lies in q's ring_buffers
+  static void forget_compaction(const queue *q) noexcept {
+    if (compact_storage::_queue == q) {
+      compact_storage::_queue = nullptr;
+      compact_storage::_resume = nullptr;
+    }
+  }
+
+  // Keep an unlinked node as a spare while there is room, free it otherwise
+  void release_ring_buffer(node_pointer node) noexcept {
+    if (compact_storage::_resume == node) { forget_compaction(this); }
+    if constexpr (spare_ring_buffers > 0) {
+      if (spare_storage::_spares.size() < spare_ring_buffers) {
+        node->value.buffer.reset();
+        spare_storage::_spares.push_front(node);
+        return;
+      }
+    }
+
+    list_type::destroy_node(node);
+    update_watermarks();
+  }
+};
+
+// Forward iterator over the chunks of a queue, one or two per ring_buffer:
+// readable data, or free slots of a write reservation when writable.
+template <is_nothrow T, size_t ring_buffer_capacity,
+          is_homogenous local_buffer_type, is_homogenous dynamic_buffer_type,
+          size_counter size_counter_type, size_t spare_ring_buffers>
+template <bool writable>
+class queue<T, ring_buffer_capacity, local_buffer_type, dynamic_buffer_type,
+            size_counter_type, spare_ring_buffers>::basic_chunk_iterator
+    : public forward_iterator_facade<
+          std::span<std::conditional_t<writable, T, const T>>,
+          std::span<std::conditional_t<writable, T, const T>>> {
+  using span_type = std::span<std::conditional_t<writable, T, const T>>;
+  using node_iterator =
+      typename offset_list<ring_buffer_node, dynamic_buffer_type>::iterator;
+
+  node_iterator _node;
+  uint8_t _part{0}; // which of the node's two spans
+
+  auto spans() const noexcept {
+    if constexpr (writable) {
+      return (*_node).buffer.write_spans();
+    } else {
+      return (*_node).buffer.read_spans();
+    }
+  }
+
+public:
+  explicit basic_chunk_iterator(node_iterator node) noexcept : _node(node) {}
+
+  span_type dereference() const noexcept { return spans()[_part]; }
+
+  void increment() noexcept {
+    if (_part == 0 && !spans()[1].empty()) {
+      _part = 1;
+    } else {
+      ++_node;
+      _part = 0;
+    }
+  }
+
+  bool equals(const basic_chunk_iterator &other) const noexcept {
+    return _node == other._node && _part == other._part;
+  }
+
+  node_iterator node() const noexcept { return _node; }
+  bool at_end() const noexcept { return _node.intrusive().node() == nullptr; }
+};
+
+template <is_nothrow T, size_t ring_buffer_capacity,
+          is_homogenous local_buffer_type, is_homogenous dynamic_buffer_type,
+          size_counter size_counter_type, size_t spare_ring_buffers>
+class queue<T, ring_buffer_capacity, local_buffer_type, dynamic_buffer_type,
+            size_counter_type, spare_ring_buffers>::const_iterator
+    : public forward_iterator_facade<const T> {
+  chunk_iterator _segment;
+  std::span<const T> _chunk; // cached *_segment, empty at the end
+  size_t _offset{0};
+
+public:
+  const_iterator(chunk_iterator segment, size_t offset) noexcept
+      : _segment(segment), _offset(offset) {
+    if (!_segment.at_end()) { _chunk = *_segment; }
+  }
+
+  const T &dereference() const noexcept { return _chunk[_offset]; }
+
+  void increment() noexcept {
+    if (++_offset < _chunk.size()) { return; }
+    ++_segment;
+    _offset = 0;
+    _chunk = _segment.at_end() ? std::span<const T>() : *_segment;
+  }
+
+  bool equals(const const_iterator &other) const noexcept {
+    return _segment == other._segment && _offset == other._offset;
+  }
+
+  chunk_iterator segment() const noexcept { return _segment; }
+  size_t offset() const noexcept { return _offset; }
 };
+
+template <is_nothrow T, size_t ring_buffer_capacity,
+          is_homogenous local_buffer_type, is_homogenous dynamic_buffer_type,
+          size_counter size_counter_type, size_t spare_ring_buffers>
+typename queue<T, ring_buffer_capacity, local_buffer_type, dynamic_buffer_type,
+               size_counter_type, spare_ring_buffers>::chunk_range
+queue<T, ring_buffer_capacity, local_buffer_type, dynamic_buffer_type,
+      size_counter_type, spare_ring_buffers>::read_chunks() const noexcept {
+  return {chunk_iterator(_list.begin()), chunk_iterator(_list.end())};
+}
+
+template <is_nothrow T, size_t ring_buffer_capacity,
+          is_homogenous local_buffer_type, is_homogenous dynamic_buffer_type,
+          size_counter size_counter_type, size_t spare_ring_buffers>
+auto queue<T, ring_buffer_capacity, local_buffer_type, dynamic_buffer_type,
+           size_counter_type, spare_ring_buffers>::begin() const noexcept
+    -> const_iterator {
+  return const_iterator(chunk_iterator(_list.begin()), 0);
+}
+
+template <is_nothrow T, size_t ring_buffer_capacity,
+          is_homogenous local_buffer_type, is_homogenous dynamic_buffer_type,
+          size_counter size_counter_type, size_t spare_ring_buffers>
+auto queue<T, ring_buffer_capacity, local_buffer_type, dynamic_buffer_type,
+           size_counter_type, spare_ring_buffers>::end() const noexcept
+    -> const_iterator {
+  return const_iterator(chunk_iterator(_list.end()), 0);
+}
+
+template <is_nothrow T, size_t ring_buffer_capacity,
+          is_homogenous local_buffer_type, is_homogenous dynamic_buffer_type,
+          size_counter size_counter_type, size_t spare_ring_buffers>
+auto queue<T, ring_buffer_capacity, local_buffer_type, dynamic_buffer_type,
+           size_counter_type,
+           spare_ring_buffers>::reserve_write(size_t n) noexcept
+    -> result<write_reservation>
+  requires std::is_trivially_copyable_v<T>
+{
+  if constexpr (counts_size) {
+    fail(n > std::numeric_limits<size_counter_type>::max() - _count,
+         "queue size counter overflow");
+  }
+
+  // Anchor on the current tail, its free slots are handed out first
+  auto anchor = _list.is_empty() ? _list.before_begin() : _list.last();
+  auto first = anchor;
+  size_t capacity = 0;
+  if (_list.is_empty() || (*first).buffer.is_full()) {
+    ++first;
+  } else {
+    capacity = (*first).buffer.get_free();
+  }
+
+  while (capacity < n) {
+    if (auto allocated = allocate_new_ring_buffer(); !allocated) {
+      // Hand back the ring_buffers reserved so far
+      release_after(anchor);
+      return std::unexpected(allocated.error());
+    }
+    if (first == _list.end()) { first = _list.last(); }
+    capacity += ring_buffer_capacity;
+  }
+
+  return write_reservation{
+      anchor, {write_iterator(first), write_iterator(_list.end())}, capacity};
+}
+
+template <is_nothrow T, size_t ring_buffer_capacity,
+          is_homogenous local_buffer_type, is_homogenous dynamic_buffer_type,
+          size_counter size_counter_type, size_t spare_ring_buffers>
+result<> queue<T, ring_buffer_capacity, local_buffer_type, dynamic_buffer_type,
+               size_counter_type, spare_ring_buffers>::
+    commit_write(const write_reservation &reservation, size_t k) noexcept
+  requires std::is_trivially_copyable_v<T>
+{
+  // reserve_write() checked n, only a k beyond it can overflow the counter
+  bool overflows = false;
+  if constexpr (counts_size) {
+    overflows = k > std::numeric_limits<size_counter_type>::max() - _count;
+  }
+  if (k > reservation.capacity || overflows) {
+    // Leave no empty ring_buffers linked
+    release_after(reservation.anchor);
+  }
+  fail(k > reservation.capacity, "commit exceeds write reservation");
+  fail(overflows, "queue size counter overflow");
+
+  // Last node holding committed data, everything after it is released
+  auto keep = reservation.anchor;
+  auto node = reservation.chunks.begin().node();
+  for (size_t remaining = k; remaining > 0; ++node) {
+    auto &buffer = (*node).buffer;
+    auto count = static_cast<typename ring_buffer_type::size_type>(
+        std::min<size_t>(remaining, buffer.get_free()));
+    buffer.commit(count);
+    remaining -= count;
+    keep = node;
+  }
+
+  release_after(keep);
+  if constexpr (counts_size) { _count += k; }
+  return {};
+}
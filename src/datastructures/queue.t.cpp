@@ -1,8 +1,21 @@
 #include "growing_pool.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdio>
 #include <gtest/gtest.h>
+#include <iterators/segmented_algorithms.h>
+#include <latch>
 #include <local_buffer.h>
+#include <mapped_buffer.h>
 #include <memory>
+#include <new>
 #include <queue.h>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 constexpr size_t local_buffer_block_size = 16;
 constexpr size_t local_buffer_block_count = 128;
@@ -13,6 +26,13 @@ using local_alloc = local_buffer(local_buffer_block_size,
 using growing_pool_alloc = growing_pool(8, 32, local_alloc);
 using test_queue =
     queue<int, ring_buffer_capacity, local_alloc, growing_pool_alloc>;
+using counted_queue =
+    queue<int, ring_buffer_capacity, local_alloc, growing_pool_alloc, uint16_t>;
+using small_counted_queue =
+    queue<int, ring_buffer_capacity, local_alloc, growing_pool_alloc, uint8_t>;
+
+static_assert(sizeof(counted_queue) > sizeof(test_queue),
+              "size counter must be stored in the queue");
 
 class QueueTest : public ::testing::Test {
 protected:
@@ -213,6 +233,230 @@ TEST_F(QueueTest, SizeAcrossMultipleRingBuffers) {
   }
 }
 
+// ============================================================================
+// Bulk Operations
+// ============================================================================
+
+TEST_F(QueueTest, PushRangeSpansRingBuffers) {
+  std::vector<int> values(ring_buffer_capacity * 2 + 1);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = static_cast<int>(i);
+  }
+
+  q->push(-1);
+  ASSERT_TRUE(q->push_range(values).has_value());
+  EXPECT_EQ(q->size(), values.size() + 1);
+
+  EXPECT_EQ(*q->pop(), -1);
+  for (int value : values) {
+    EXPECT_EQ(*q->pop(), value);
+  }
+  EXPECT_TRUE(q->empty());
+}
+
+TEST_F(QueueTest, PopNSpansRingBuffers) {
+  for (int i = 0; i < ring_buffer_capacity * 3; ++i) {
+    q->push(i);
+  }
+  q->pop();
+
+  std::vector<int> out(ring_buffer_capacity * 2);
+  auto popped = q->pop_n(out);
+  ASSERT_TRUE(popped.has_value());
+  EXPECT_EQ(*popped, out.size());
+  for (size_t i = 0; i < out.size(); ++i) {
+    EXPECT_EQ(out[i], static_cast<int>(i + 1));
+  }
+
+  EXPECT_EQ(q->size(), ring_buffer_capacity - 1);
+  EXPECT_EQ(**q->front(), static_cast<int>(ring_buffer_capacity * 2 + 1));
+}
+
+TEST_F(QueueTest, PopNDrainsShortQueue) {
+  q->push(1);
+  q->push(2);
+
+  std::vector<int> out(ring_buffer_capacity);
+  EXPECT_EQ(*q->pop_n(out), 2);
+  EXPECT_EQ(out[0], 1);
+  EXPECT_EQ(out[1], 2);
+  EXPECT_TRUE(q->empty());
+  EXPECT_EQ(*q->pop_n(out), 0);
+}
+
+// ============================================================================
+// Zero-Copy Reads
+// ============================================================================
+
+TEST_F(QueueTest, ReadChunksCoverAllElementsInOrder) {
+  // Leave the head buffer partially consumed and the tail buffer partial
+  for (int i = 0; i < ring_buffer_capacity * 3 - 1; ++i) {
+    q->push(i);
+  }
+  q->pop();
+
+  std::vector<int> seen;
+  for (std::span<const int> chunk : q->read_chunks()) {
+    EXPECT_FALSE(chunk.empty());
+    seen.insert(seen.end(), chunk.begin(), chunk.end());
+  }
+
+  ASSERT_EQ(seen.size(), q->size());
+  for (size_t i = 0; i < seen.size(); ++i) {
+    EXPECT_EQ(seen[i], static_cast<int>(i + 1));
+  }
+}
+
+TEST_F(QueueTest, ReadChunksSplitWrappedBuffer) {
+  for (int i = 0; i < ring_buffer_capacity; ++i) {
+    q->push(i);
+  }
+  q->pop();
+  q->pop();
+
+  // The front buffer is not full, so these wrap around inside it
+  q->push(100);
+  q->push(101);
+
+  std::vector<size_t> sizes;
+  for (auto chunk : q->read_chunks()) {
+    sizes.push_back(chunk.size());
+  }
+  ASSERT_EQ(sizes.size(), 2);
+  EXPECT_EQ(sizes[0], ring_buffer_capacity - 2);
+  EXPECT_EQ(sizes[1], 2);
+}
+
+TEST_F(QueueTest, ReadChunksEmptyQueue) {
+  auto chunks = q->read_chunks();
+  EXPECT_EQ(chunks.begin(), chunks.end());
+}
+
+TEST_F(QueueTest, PeekReturnsOldestChunk) {
+  EXPECT_FALSE(q->peek().has_value());
+
+  q->push(1);
+  q->push(2);
+
+  auto chunk = q->peek();
+  ASSERT_TRUE(chunk.has_value());
+  ASSERT_EQ(chunk->size(), 2);
+  EXPECT_EQ((*chunk)[0], 1);
+  EXPECT_EQ((*chunk)[1], 2);
+}
+
+TEST_F(QueueTest, ConsumeAcrossRingBuffers) {
+  for (int i = 0; i < ring_buffer_capacity * 3; ++i) {
+    q->push(i);
+  }
+
+  ASSERT_TRUE(q->consume(ring_buffer_capacity + 1).has_value());
+  EXPECT_EQ(q->size(), ring_buffer_capacity * 2 - 1);
+  EXPECT_EQ(**q->front(), static_cast<int>(ring_buffer_capacity + 1));
+
+  ASSERT_TRUE(q->consume(q->size()).has_value());
+  EXPECT_TRUE(q->empty());
+}
+
+TEST_F(QueueTest, ConsumePastEndFails) {
+  q->push(1);
+  EXPECT_FALSE(q->consume(2).has_value());
+  EXPECT_TRUE(q->empty());
+}
+
+// ============================================================================
+// Write Reservations
+// ============================================================================
+
+TEST_F(QueueTest, ReserveWriteFillsInPlace) {
+  q->push(-1);
+
+  auto reservation = q->reserve_write(ring_buffer_capacity * 2);
+  ASSERT_TRUE(reservation.has_value());
+  ASSERT_GE(reservation->capacity, ring_buffer_capacity * 2);
+
+  int next = 0;
+  for (std::span<int> chunk : *reservation) {
+    for (int &slot : chunk) {
+      slot = next++;
+    }
+  }
+  EXPECT_EQ(next, static_cast<int>(reservation->capacity));
+
+  size_t committed = ring_buffer_capacity + 2;
+  ASSERT_TRUE(q->commit_write(*reservation, committed).has_value());
+  EXPECT_EQ(q->size(), committed + 1);
+
+  EXPECT_EQ(*q->pop(), -1);
+  for (size_t i = 0; i < committed; ++i) {
+    EXPECT_EQ(*q->pop(), static_cast<int>(i));
+  }
+  EXPECT_TRUE(q->empty());
+}
+
+TEST_F(QueueTest, CommitReleasesUnusedReservedBuffers) {
+  auto reservation = q->reserve_write(ring_buffer_capacity * 3);
+  ASSERT_TRUE(reservation.has_value());
+
+  for (std::span<int> chunk : *reservation) {
+    std::fill(chunk.begin(), chunk.end(), 7);
+  }
+  ASSERT_TRUE(q->commit_write(*reservation, 1).has_value());
+
+  // Only the ring_buffer holding the committed element remains
+  size_t chunks = 0;
+  for (auto chunk : q->read_chunks()) {
+    EXPECT_EQ(chunk.size(), 1);
+    ++chunks;
+  }
+  EXPECT_EQ(chunks, 1);
+  EXPECT_EQ(**q->back(), 7);
+}
+
+TEST_F(QueueTest, CommitZeroAbandonsReservation) {
+  auto reservation = q->reserve_write(ring_buffer_capacity * 3);
+  ASSERT_TRUE(reservation.has_value());
+
+  ASSERT_TRUE(q->commit_write(*reservation, 0).has_value());
+  EXPECT_TRUE(q->empty());
+
+  q->push(5);
+  EXPECT_EQ(*q->pop(), 5);
+}
+
+TEST_F(QueueTest, CommitBeyondReservationFails) {
+  auto reservation = q->reserve_write(1);
+  ASSERT_TRUE(reservation.has_value());
+
+  EXPECT_FALSE(
+      q->commit_write(*reservation, reservation->capacity + 1).has_value());
+  // The failed commit abandoned the reservation
+  EXPECT_TRUE(q->empty());
+  EXPECT_FALSE(q->front().has_value());
+  EXPECT_FALSE(q->pop().has_value());
+}
+
+TEST_F(QueueTest, FailedCommitLeavesQueueUsable) {
+  q->push(-1);
+  auto reservation = q->reserve_write(ring_buffer_capacity * 3);
+  ASSERT_TRUE(reservation.has_value());
+
+  EXPECT_FALSE(
+      q->commit_write(*reservation, reservation->capacity + 1).has_value());
+  EXPECT_EQ(q->size(), 1);
+  size_t chunks = 0;
+  for (auto chunk : q->read_chunks()) {
+    EXPECT_EQ(chunk.size(), 1);
+    ++chunks;
+  }
+  EXPECT_EQ(chunks, 1);
+
+  q->push(5);
+  EXPECT_EQ(*q->pop(), -1);
+  EXPECT_EQ(*q->pop(), 5);
+  EXPECT_TRUE(q->empty());
+}
+
 // ============================================================================
 // Stress Test
 // ============================================================================
@@ -243,3 +487,1197 @@ TEST_F(QueueTest, PushPopCycle) {
     EXPECT_TRUE(q->empty());
   }
 }
+
+// ============================================================================
+// Element Iterators and Segmented Algorithms
+// ============================================================================
+
+static_assert(segmented_iterator<test_queue::const_iterator>);
+
+TEST_F(QueueTest, IteratesElementsInOrder) {
+  // Wrap the first ring_buffer so its data spans two chunks
+  for (int i = 0; i < ring_buffer_capacity; ++i) {
+    q->push(i);
+  }
+  q->pop();
+  q->pop();
+  for (int i = ring_buffer_capacity; i < ring_buffer_capacity * 3; ++i) {
+    q->push(i);
+  }
+
+  int expected = 2;
+  for (int value : *q) {
+    EXPECT_EQ(value, expected++);
+  }
+  EXPECT_EQ(expected, ring_buffer_capacity * 3);
+}
+
+TEST_F(QueueTest, EmptyQueueBeginEqualsEnd) {
+  EXPECT_EQ(q->begin(), q->end());
+  EXPECT_EQ(segmented::count(*q, 0), 0);
+  EXPECT_EQ(segmented::find(*q, 0), q->end());
+}
+
+TEST_F(QueueTest, SegmentedForEachVisitsAllElements) {
+  for (int i = 0; i < ring_buffer_capacity * 3 + 1; ++i) {
+    q->push(i);
+  }
+
+  std::vector<int> seen;
+  segmented::for_each(*q, [&](int value) { seen.push_back(value); });
+
+  ASSERT_EQ(seen.size(), ring_buffer_capacity * 3 + 1);
+  for (int i = 0; i < static_cast<int>(seen.size()); ++i) {
+    EXPECT_EQ(seen[i], i);
+  }
+}
+
+TEST_F(QueueTest, SegmentedFindAcrossRingBuffers) {
+  for (int i = 0; i < ring_buffer_capacity * 3; ++i) {
+    q->push(i);
+  }
+
+  auto it = segmented::find(*q, static_cast<int>(ring_buffer_capacity) + 1);
+  ASSERT_NE(it, q->end());
+  EXPECT_EQ(*it, static_cast<int>(ring_buffer_capacity) + 1);
+
+  // Continuing from the result matches plain iteration
+  ++it;
+  EXPECT_EQ(*it, static_cast<int>(ring_buffer_capacity) + 2);
+  EXPECT_EQ(segmented::find(*q, -1), q->end());
+}
+
+TEST_F(QueueTest, SegmentedCountAndCopyOnSubrange) {
+  for (int i = 0; i < ring_buffer_capacity * 3; ++i) {
+    q->push(i % 3);
+  }
+  EXPECT_EQ(segmented::count(*q, 0), ring_buffer_capacity);
+
+  // From the second element up to the first 2 of the second ring_buffer
+  auto first = std::next(q->begin());
+  auto last = segmented::find(first, q->end(), 2);
+  last = segmented::find(std::next(last), q->end(), 2);
+
+  std::vector<int> out(8, -1);
+  auto out_end = segmented::copy(first, last, out.begin());
+  EXPECT_EQ(std::vector<int>(out.begin(), out_end),
+            (std::vector<int>{1, 2, 0, 1}));
+  EXPECT_EQ(segmented::count(first, last, 2), 1);
+}
+
+// ============================================================================
+// Byte Queues - Delimiters and Records
+// ============================================================================
+
+constexpr size_t byte_ring_buffer_capacity = 8;
+using byte_test_queue = queue<unsigned char, byte_ring_buffer_capacity,
+                              local_alloc, growing_pool_alloc>;
+
+class ByteQueueTest : public ::testing::Test {
+protected:
+  std::unique_ptr<local_alloc> local_allocator;
+  std::unique_ptr<growing_pool_alloc> list_allocator;
+  std::unique_ptr<byte_test_queue> q;
+
+  void SetUp() override {
+    local_allocator = std::make_unique<local_alloc>();
+    list_allocator =
+        std::make_unique<growing_pool_alloc>(local_allocator.get());
+    q = std::make_unique<byte_test_queue>(local_allocator.get(),
+                                          list_allocator.get());
+  }
+
+  void TearDown() override { q.reset(); }
+
+  void push_text(std::string_view text) {
+    for (char c : text) {
+      ASSERT_TRUE(q->push(static_cast<unsigned char>(c)).has_value());
+    }
+  }
+
+  static std::string_view text(std::span<const unsigned char> bytes) {
+    return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+  }
+};
+
+TEST_F(ByteQueueTest, FindLocatesByteAcrossRingBuffers) {
+  push_text("first line\nsecond\n");
+
+  EXPECT_EQ(*q->find('\n'), 10);
+  EXPECT_EQ(*q->find('d'), 16);
+  EXPECT_FALSE(q->find('x').has_value());
+}
+
+TEST_F(ByteQueueTest, ReadUntilPopsThroughDelimiter) {
+  push_text("first line\nsecond\n");
+  std::vector<unsigned char> out(32);
+
+  size_t length = *q->read_until('\n', out);
+  EXPECT_EQ(text(std::span(out).first(length)), "first line\n");
+  length = *q->read_until('\n', out);
+  EXPECT_EQ(text(std::span(out).first(length)), "second\n");
+  EXPECT_TRUE(q->empty());
+}
+
+TEST_F(ByteQueueTest, ReadUntilWithoutDelimiterKeepsData) {
+  push_text("partial");
+  std::vector<unsigned char> out(32);
+
+  EXPECT_FALSE(q->read_until('\n', out).has_value());
+  EXPECT_EQ(q->size(), 7);
+
+  push_text(" line\n");
+  size_t length = *q->read_until('\n', out);
+  EXPECT_EQ(text(std::span(out).first(length)), "partial line\n");
+}
+
+TEST_F(ByteQueueTest, ReadUntilOutputTooSmallKeepsData) {
+  push_text("a long line\n");
+  std::vector<unsigned char> out(4);
+
+  EXPECT_FALSE(q->read_until('\n', out).has_value());
+  EXPECT_EQ(q->size(), 12);
+}
+
+TEST_F(ByteQueueTest, RecordsRoundTripAcrossRingBuffers) {
+  std::string_view first = "a payload longer than a ring buffer";
+  std::string_view second = "x";
+  auto bytes = [](std::string_view s) {
+    return std::span(reinterpret_cast<const unsigned char *>(s.data()),
+                     s.size());
+  };
+
+  ASSERT_TRUE(q->write_record(bytes(first)).has_value());
+  ASSERT_TRUE(q->write_record(bytes(second)).has_value());
+  ASSERT_TRUE(q->write_record({}).has_value());
+  EXPECT_EQ(q->size(), first.size() + second.size() +
+                           3 * byte_test_queue::record_header_size);
+
+  std::vector<unsigned char> out(64);
+  size_t length = *q->read_record(out);
+  EXPECT_EQ(text(std::span(out).first(length)), first);
+  length = *q->read_record(out);
+  EXPECT_EQ(text(std::span(out).first(length)), second);
+  EXPECT_EQ(*q->read_record(out), 0);
+  EXPECT_TRUE(q->empty());
+}
+
+TEST_F(ByteQueueTest, HeaderIsLittleEndianLength) {
+  std::vector<unsigned char> payload(0x102, 7);
+  ASSERT_TRUE(q->write_record(payload).has_value());
+
+  EXPECT_EQ(*q->pop(), 0x02);
+  EXPECT_EQ(*q->pop(), 0x01);
+  EXPECT_EQ(*q->pop(), 0x00);
+  EXPECT_EQ(*q->pop(), 0x00);
+}
+
+TEST_F(ByteQueueTest, IncompleteRecordKeepsData) {
+  std::vector<unsigned char> out(64);
+
+  // Partial header, then a header announcing more payload than queued
+  push_text(std::string_view("\x05\x00", 2));
+  EXPECT_FALSE(q->read_record(out).has_value());
+  push_text(std::string_view("\x00\x00"
+                             "abc",
+                             5));
+  EXPECT_FALSE(q->read_record(out).has_value());
+  EXPECT_EQ(q->size(), 7);
+
+  push_text("de");
+  size_t length = *q->read_record(out);
+  EXPECT_EQ(text(std::span(out).first(length)), "abcde");
+}
+
+TEST_F(ByteQueueTest, RecordOutputTooSmallKeepsData) {
+  push_text(std::string_view("\x03\x00\x00\x00"
+                             "abc",
+                             7));
+  std::vector<unsigned char> out(2);
+
+  EXPECT_FALSE(q->read_record(out).has_value());
+  EXPECT_EQ(q->size(), 7);
+}
+
+// ============================================================================
+// Splice and Take All
+// ============================================================================
+
+TEST_F(QueueTest, SpliceBackAppendsInOrder) {
+  test_queue other(local_allocator.get(), list_allocator.get());
+  for (int i = 0; i < ring_buffer_capacity + 1; ++i) {
+    q->push(i);
+  }
+  for (int i = 0; i < ring_buffer_capacity * 2; ++i) {
+    other.push(100 + i);
+  }
+
+  ASSERT_TRUE(q->splice_back(other).has_value());
+  EXPECT_TRUE(other.empty());
+  EXPECT_EQ(q->size(), ring_buffer_capacity * 3 + 1);
+
+  // Pushes continue after the spliced elements
+  q->push(999);
+  for (int i = 0; i < ring_buffer_capacity + 1; ++i) {
+    EXPECT_EQ(*q->pop(), i);
+  }
+  for (int i = 0; i < ring_buffer_capacity * 2; ++i) {
+    EXPECT_EQ(*q->pop(), 100 + i);
+  }
+  EXPECT_EQ(*q->pop(), 999);
+  EXPECT_TRUE(q->empty());
+}
+
+TEST_F(QueueTest, SpliceBackIntoEmptyQueue) {
+  test_queue other(local_allocator.get(), list_allocator.get());
+  other.push(1);
+  other.push(2);
+
+  ASSERT_TRUE(q->splice_back(other).has_value());
+  EXPECT_EQ(*q->front(), 1);
+  EXPECT_EQ(*q->back(), 2);
+
+  // The emptied queue is usable again
+  other.push(3);
+  EXPECT_EQ(*other.pop(), 3);
+}
+
+TEST_F(QueueTest, SpliceBackEmptyQueueIsNoop) {
+  test_queue other(local_allocator.get(), list_allocator.get());
+  q->push(1);
+
+  ASSERT_TRUE(q->splice_back(other).has_value());
+  EXPECT_EQ(q->size(), 1);
+  EXPECT_EQ(*q->back(), 1);
+}
+
+TEST_F(QueueTest, SpliceBackIntoItselfFails) {
+  q->push(1);
+  EXPECT_FALSE(q->splice_back(*q).has_value());
+  EXPECT_EQ(q->size(), 1);
+}
+
+TEST_F(QueueTest, TakeAllReplacesContents) {
+  test_queue other(local_allocator.get(), list_allocator.get());
+  q->push(1);
+  for (int i = 0; i < ring_buffer_capacity + 1; ++i) {
+    other.push(10 + i);
+  }
+
+  ASSERT_TRUE(q->take_all(other).has_value());
+  EXPECT_TRUE(other.empty());
+  EXPECT_EQ(q->size(), ring_buffer_capacity + 1);
+  EXPECT_EQ(*q->front(), 10);
+}
+
+// ============================================================================
+// Double-Ended Operations
+// ============================================================================
+
+TEST_F(QueueTest, PushFrontIsPoppedNext) {
+  q->push(1);
+  q->push(2);
+  ASSERT_TRUE(q->push_front(0).has_value());
+
+  EXPECT_EQ(*q->front(), 0);
+  EXPECT_EQ(q->size(), 3);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(*q->pop(), i);
+  }
+}
+
+TEST_F(QueueTest, PushFrontLinksRingBufferBeforeFullFront) {
+  for (int i = 0; i < ring_buffer_capacity; ++i) {
+    q->push(i);
+  }
+  // The oldest ring_buffer is full, retried items go into a new one
+  for (int i = 1; i <= ring_buffer_capacity + 1; ++i) {
+    ASSERT_TRUE(q->emplace_front(-i).has_value());
+  }
+
+  EXPECT_EQ(q->size(), ring_buffer_capacity * 2 + 1);
+  for (int i = ring_buffer_capacity + 1; i >= 1; --i) {
+    EXPECT_EQ(*q->pop(), -i);
+  }
+  for (int i = 0; i < ring_buffer_capacity; ++i) {
+    EXPECT_EQ(*q->pop(), i);
+  }
+  EXPECT_TRUE(q->empty());
+}
+
+TEST_F(QueueTest, PopBackReturnsNewestAcrossRingBuffers) {
+  for (int i = 0; i < ring_buffer_capacity * 2 + 1; ++i) {
+    q->push(i);
+  }
+
+  for (int i = ring_buffer_capacity * 2; i >= 0; --i) {
+    EXPECT_EQ(*q->back(), i);
+    EXPECT_EQ(*q->pop_back(), i);
+  }
+  EXPECT_TRUE(q->empty());
+  EXPECT_FALSE(q->pop_back().has_value());
+}
+
+TEST_F(QueueTest, PopBackFollowsRelinkedRingBuffers) {
+  // A ring_buffer linked at the front, one shrunk from the back, two
+  // spliced in, and compact() merging the small ones into the first
+  for (int i = 0; i < ring_buffer_capacity; ++i) {
+    q->push(i);
+  }
+  q->push_front(-1);
+  q->pop_back();
+  q->pop_back();
+
+  test_queue other(local_allocator.get(), list_allocator.get());
+  for (int i = 0; i < ring_buffer_capacity * 2; ++i) {
+    other.push(100 + i);
+  }
+  for (int i = 0; i < ring_buffer_capacity - 1; ++i) {
+    other.pop();
+  }
+  ASSERT_TRUE(q->splice_back(other).has_value());
+  EXPECT_EQ(q->compact(ring_buffer_capacity * 4), 2);
+
+  std::vector<int> expected(q->begin(), q->end());
+  ASSERT_EQ(expected.size(), ring_buffer_capacity * 2);
+  while (!expected.empty()) {
+    EXPECT_EQ(*q->pop_back(), expected.back());
+    expected.pop_back();
+  }
+  EXPECT_TRUE(q->empty());
+}
+
+TEST_F(QueueTest, DequeOperationsOnEmptyQueue) {
+  ASSERT_TRUE(q->push_front(5).has_value());
+  EXPECT_EQ(*q->front(), 5);
+  EXPECT_EQ(*q->back(), 5);
+  EXPECT_EQ(*q->pop_back(), 5);
+  EXPECT_TRUE(q->empty());
+
+  // The queue stays usable from both ends
+  q->push(1);
+  q->push_front(0);
+  EXPECT_EQ(*q->pop_back(), 1);
+  EXPECT_EQ(*q->pop(), 0);
+}
+
+TEST_F(QueueTest, PopBackReleasesRingBuffers) {
+  test_queue other(local_allocator.get(), list_allocator.get());
+  // Repeated growth and shrinking at the back must not leak ring_buffers
+  for (int cycle = 0; cycle < 50; ++cycle) {
+    for (int i = 0; i < ring_buffer_capacity * 3; ++i) {
+      ASSERT_TRUE(other.push(i).has_value());
+    }
+    for (int i = 0; i < ring_buffer_capacity * 3; ++i) {
+      ASSERT_TRUE(other.pop_back().has_value());
+    }
+  }
+  EXPECT_TRUE(other.empty());
+}
+
+// ============================================================================
+// Compaction
+// ============================================================================
+
+// Each spliced queue contributes its own, mostly empty, ring_buffer
+static size_t count_chunks(const test_queue &q) {
+  size_t chunks = 0;
+  for ([[maybe_unused]] auto chunk : q.read_chunks()) {
+    ++chunks;
+  }
+  return chunks;
+}
+
+TEST_F(QueueTest, CompactMergesSparseRingBuffers) {
+  for (int i = 0; i < ring_buffer_capacity; ++i) {
+    test_queue other(local_allocator.get(), list_allocator.get());
+    other.push(i);
+    ASSERT_TRUE(q->splice_back(other).has_value());
+  }
+  ASSERT_EQ(count_chunks(*q), ring_buffer_capacity);
+
+  EXPECT_EQ(q->compact(100), ring_buffer_capacity - 1);
+  EXPECT_EQ(count_chunks(*q), 1);
+  EXPECT_EQ(q->size(), ring_buffer_capacity);
+  for (int i = 0; i < ring_buffer_capacity; ++i) {
+    EXPECT_EQ(*q->pop(), i);
+  }
+}
+
+TEST_F(QueueTest, CompactStopsAtBudget) {
+  for (int i = 0; i < ring_buffer_capacity; ++i) {
+    test_queue other(local_allocator.get(), list_allocator.get());
+    other.push(i);
+    ASSERT_TRUE(q->splice_back(other).has_value());
+  }
+
+  // One element moved per call
+  for (int i = 0; i < ring_buffer_capacity - 1; ++i) {
+    EXPECT_EQ(q->compact(1), 1);
+  }
+  EXPECT_EQ(q->compact(1), 0);
+  EXPECT_EQ(q->compact(0), 0);
+  for (int i = 0; i < ring_buffer_capacity; ++i) {
+    EXPECT_EQ(*q->pop(), i);
+  }
+}
+
+TEST_F(QueueTest, CompactKeepsFullRingBuffers) {
+  for (int i = 0; i < ring_buffer_capacity * 2 + 1; ++i) {
+    q->push(i);
+  }
+
+  EXPECT_EQ(q->compact(100), 0);
+  EXPECT_EQ(q->size(), ring_buffer_capacity * 2 + 1);
+  EXPECT_EQ(*q->back(), ring_buffer_capacity * 2);
+}
+
+TEST_F(QueueTest, CompactMergesIntoWrappedRingBuffer) {
+  for (int i = 0; i < ring_buffer_capacity; ++i) {
+    q->push(i);
+  }
+  for (int i = 0; i < ring_buffer_capacity - 1; ++i) {
+    q->pop();
+  }
+  // Head sits at the last slot, so the merged elements wrap around
+  q->push(ring_buffer_capacity);
+
+  test_queue other(local_allocator.get(), list_allocator.get());
+  other.push(ring_buffer_capacity + 1);
+  other.push(ring_buffer_capacity + 2);
+  ASSERT_TRUE(q->splice_back(other).has_value());
+
+  EXPECT_EQ(q->compact(100), 1);
+  for (int i = ring_buffer_capacity - 1; i < ring_buffer_capacity + 3; ++i) {
+    EXPECT_EQ(*q->pop(), i);
+  }
+  EXPECT_TRUE(q->empty());
+}
+
+// full_ring_buffers full ring_buffers followed by two mergeable ones
+static void push_deep_chain(test_queue &q, test_queue &other,
+                            int full_ring_buffers) {
+  for (int i = 0; i < ring_buffer_capacity * full_ring_buffers; ++i) {
+    q.push(i);
+  }
+  for (int i = 0; i < 2; ++i) {
+    other.push(-1);
+    ASSERT_TRUE(q.splice_back(other).has_value());
+  }
+}
+
+TEST_F(QueueTest, CompactSkipsAtMostBudgetRingBuffers) {
+  constexpr int full_ring_buffers = 24;
+  constexpr int budget = 4;
+  test_queue other(local_allocator.get(), list_allocator.get());
+  push_deep_chain(*q, other, full_ring_buffers);
+
+  // Each call walks past budget full ring_buffers and resumes there, so the
+  // mergeable pair at the back is only reached by the last call
+  for (int i = 0; i < full_ring_buffers / budget; ++i) {
+    EXPECT_EQ(q->compact(budget), 0);
+    EXPECT_TRUE(q->compacting());
+  }
+  EXPECT_EQ(q->compact(budget), 1);
+  EXPECT_FALSE(q->compacting());
+  EXPECT_EQ(*q->back(), -1);
+}
+
+TEST_F(QueueTest, CompactRestartsWhenResumePointIsReleased) {
+  constexpr int full_ring_buffers = 8;
+  test_queue other(local_allocator.get(), list_allocator.get());
+  push_deep_chain(*q, other, full_ring_buffers);
+
+  EXPECT_EQ(q->compact(4), 0);
+  ASSERT_TRUE(q->compacting());
+  // Popping past the resume point frees its ring_buffer
+  for (int i = 0; i < ring_buffer_capacity * 5; ++i) {
+    EXPECT_EQ(*q->pop(), i);
+  }
+  EXPECT_FALSE(q->compacting());
+
+  EXPECT_EQ(q->compact(100), 1);
+  EXPECT_EQ(q->size(), ring_buffer_capacity * (full_ring_buffers - 5) + 2);
+}
+
+// ============================================================================
+// Snapshots
+// ============================================================================
+
+static std::vector<std::byte> snapshot(const test_queue &q) {
+  std::vector<std::byte> image(q.serialized_size());
+  auto written = q.serialize(image);
+  EXPECT_TRUE(written.has_value());
+  EXPECT_EQ(written.value_or(0), image.size());
+  return image;
+}
+
+TEST_F(QueueTest, SnapshotRoundTripsAcrossRingBuffers) {
+  constexpr int first = ring_buffer_capacity - 2;
+  constexpr int last = ring_buffer_capacity * 3 + 1;
+
+  // Drift the head so the oldest ring_buffer wraps
+  for (int i = 0; i < ring_buffer_capacity; ++i) {
+    q->push(i);
+  }
+  for (int i = 0; i < first; ++i) {
+    q->pop();
+  }
+  for (int i = ring_buffer_capacity; i < last; ++i) {
+    q->push(i);
+  }
+
+  auto image = snapshot(*q);
+  EXPECT_EQ(image.size(),
+            sizeof(test_queue::snapshot_header) + (last - first) * sizeof(int));
+  EXPECT_EQ(q->size(), last - first);
+
+  test_queue restored(local_allocator.get(), list_allocator.get());
+  EXPECT_EQ(*restored.deserialize(image), image.size());
+  EXPECT_EQ(restored.size(), last - first);
+  for (int i = first; i < last; ++i) {
+    EXPECT_EQ(*restored.pop(), i);
+  }
+  EXPECT_TRUE(restored.empty());
+}
+
+TEST_F(QueueTest, SnapshotOfEmptyQueueIsHeaderOnly) {
+  auto image = snapshot(*q);
+  EXPECT_EQ(image.size(), sizeof(test_queue::snapshot_header));
+
+  q->push(1);
+  EXPECT_EQ(*q->deserialize(image), image.size());
+  EXPECT_TRUE(q->empty());
+}
+
+TEST_F(QueueTest, SerializeOutputTooSmallFails) {
+  q->push(1);
+  q->push(2);
+  std::vector<std::byte> image(q->serialized_size() - 1);
+  EXPECT_FALSE(q->serialize(image).has_value());
+}
+
+TEST_F(QueueTest, DeserializeReplacesContents) {
+  for (int i = 0; i < ring_buffer_capacity + 1; ++i) {
+    q->push(i);
+  }
+  auto image = snapshot(*q);
+
+  test_queue other(local_allocator.get(), list_allocator.get());
+  other.push(100);
+  other.push(101);
+  ASSERT_TRUE(other.deserialize(image).has_value());
+  EXPECT_EQ(other.size(), ring_buffer_capacity + 1);
+  EXPECT_EQ(*other.front(), 0);
+  EXPECT_EQ(*other.back(), ring_buffer_capacity);
+}
+
+TEST_F(QueueTest, DeserializeRejectsInvalidImages) {
+  for (int i = 0; i < ring_buffer_capacity + 1; ++i) {
+    q->push(i);
+  }
+  auto image = snapshot(*q);
+
+  test_queue other(local_allocator.get(), list_allocator.get());
+  other.push(100);
+
+  auto truncated = std::span<const std::byte>(image).first(image.size() - 1);
+  EXPECT_FALSE(other.deserialize(truncated).has_value());
+  auto header_only = truncated.first(sizeof(test_queue::snapshot_header) - 1);
+  EXPECT_FALSE(other.deserialize(header_only).has_value());
+
+  auto wrong_version = image;
+  wrong_version[offsetof(test_queue::snapshot_header, version)] ^=
+      std::byte{0xff};
+  EXPECT_FALSE(other.deserialize(wrong_version).has_value());
+
+  auto garbage = image;
+  garbage[0] ^= std::byte{0xff};
+  EXPECT_FALSE(other.deserialize(garbage).has_value());
+
+  // A failed restore leaves the queue as it was
+  EXPECT_EQ(other.size(), 1);
+  EXPECT_EQ(*other.front(), 100);
+}
+
+TEST_F(QueueTest, DeserializeRejectsOtherElementSize) {
+  q->push(1);
+  auto image = snapshot(*q);
+
+  byte_test_queue bytes(local_allocator.get(), list_allocator.get());
+  EXPECT_FALSE(bytes.deserialize(image).has_value());
+  EXPECT_TRUE(bytes.empty());
+}
+
+// ============================================================================
+// Size Counter
+// ============================================================================
+
+class CountedQueueTest : public ::testing::Test {
+protected:
+  std::unique_ptr<local_alloc> local_allocator;
+  std::unique_ptr<growing_pool_alloc> list_allocator;
+  counted_queue *q;
+
+  void SetUp() override {
+    local_allocator = std::make_unique<local_alloc>();
+    list_allocator =
+        std::make_unique<growing_pool_alloc>(local_allocator.get());
+    q = new counted_queue(local_allocator.get(), list_allocator.get());
+  }
+
+  void TearDown() override { delete q; }
+};
+
+TEST_F(CountedQueueTest, SizeTracksPushEmplacePop) {
+  for (int i = 0; i < ring_buffer_capacity * 3; ++i) {
+    if (i % 2 == 0) {
+      q->push(i);
+    } else {
+      q->emplace(i);
+    }
+    EXPECT_EQ(q->size(), i + 1);
+  }
+
+  for (int i = 0; i < ring_buffer_capacity * 3; ++i) {
+    EXPECT_EQ(*q->pop(), i);
+    EXPECT_EQ(q->size(), ring_buffer_capacity * 3 - i - 1);
+  }
+  EXPECT_TRUE(q->empty());
+}
+
+TEST_F(CountedQueueTest, FailedPopKeepsSize) {
+  EXPECT_FALSE(q->pop().has_value());
+  EXPECT_EQ(q->size(), 0);
+}
+
+TEST_F(CountedQueueTest, ClearResetsSize) {
+  for (int i = 0; i < ring_buffer_capacity * 2; ++i) {
+    q->push(i);
+  }
+
+  q->clear();
+  EXPECT_EQ(q->size(), 0);
+
+  q->push(1);
+  EXPECT_EQ(q->size(), 1);
+}
+
+TEST_F(CountedQueueTest, BulkOperationsTrackSize) {
+  std::vector<int> values(ring_buffer_capacity * 2 + 1, 7);
+  ASSERT_TRUE(q->push_range(values).has_value());
+  EXPECT_EQ(q->size(), values.size());
+
+  std::vector<int> out(ring_buffer_capacity + 1);
+  EXPECT_EQ(*q->pop_n(out), out.size());
+  EXPECT_EQ(q->size(), values.size() - out.size());
+}
+
+TEST_F(CountedQueueTest, SpliceBackMovesCount) {
+  counted_queue other(local_allocator.get(), list_allocator.get());
+  q->push(1);
+  for (int i = 0; i < ring_buffer_capacity + 2; ++i) {
+    other.push(i);
+  }
+
+  ASSERT_TRUE(q->splice_back(other).has_value());
+  EXPECT_EQ(q->size(), ring_buffer_capacity + 3);
+  EXPECT_EQ(other.size(), 0);
+}
+
+TEST_F(CountedQueueTest, SpliceBackOverflowFails) {
+  small_counted_queue small{local_allocator.get(), list_allocator.get()};
+  small_counted_queue other{local_allocator.get(), list_allocator.get()};
+  // One past the counter's limit, in as many ring_buffers as the overflow
+  // test above
+  constexpr int kept = std::numeric_limits<uint8_t>::max() - 3;
+  for (int i = 0; i < kept; ++i) {
+    ASSERT_TRUE(small.push(i).has_value());
+  }
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(other.push(i).has_value());
+  }
+
+  EXPECT_FALSE(small.splice_back(other).has_value());
+  EXPECT_EQ(small.size(), kept);
+  EXPECT_EQ(other.size(), 4);
+}
+
+TEST_F(CountedQueueTest, CounterOverflowFailsPush) {
+  small_counted_queue small{local_allocator.get(), list_allocator.get()};
+
+  for (int i = 0; i < std::numeric_limits<uint8_t>::max(); ++i) {
+    ASSERT_TRUE(small.push(i).has_value());
+  }
+
+  EXPECT_FALSE(small.push(0).has_value());
+  EXPECT_EQ(small.size(), std::numeric_limits<uint8_t>::max());
+}
+
+TEST_F(CountedQueueTest, ReserveBeyondCounterFails) {
+  small_counted_queue small{local_allocator.get(), list_allocator.get()};
+  for (int i = 0; i < std::numeric_limits<uint8_t>::max() - 1; ++i) {
+    ASSERT_TRUE(small.push(i).has_value());
+  }
+
+  EXPECT_FALSE(small.reserve_write(2).has_value());
+
+  // The tail's two free slots are reserved, committing both would overflow
+  auto reservation = small.reserve_write(1);
+  ASSERT_TRUE(reservation.has_value());
+  ASSERT_EQ(reservation->capacity, 2);
+  EXPECT_FALSE(small.commit_write(*reservation, 2).has_value());
+  EXPECT_EQ(small.size(), std::numeric_limits<uint8_t>::max() - 1);
+
+  auto retry = small.reserve_write(1);
+  ASSERT_TRUE(retry.has_value());
+  ASSERT_TRUE(small.commit_write(*retry, 1).has_value());
+  EXPECT_EQ(small.size(), std::numeric_limits<uint8_t>::max());
+}
+
+TEST_F(CountedQueueTest, DequeOperationsTrackSize) {
+  q->push(1);
+  q->push_front(0);
+  q->emplace_front(-1);
+  EXPECT_EQ(q->size(), 3);
+
+  q->pop_back();
+  EXPECT_EQ(q->size(), 2);
+  q->pop_back();
+  q->pop_back();
+  EXPECT_EQ(q->size(), 0);
+  EXPECT_FALSE(q->pop_back().has_value());
+  EXPECT_EQ(q->size(), 0);
+}
+
+TEST_F(CountedQueueTest, DeserializeSetsCount) {
+  for (int i = 0; i < ring_buffer_capacity * 2 + 1; ++i) {
+    q->push(i);
+  }
+  std::vector<std::byte> image(q->serialized_size());
+  ASSERT_TRUE(q->serialize(image).has_value());
+
+  counted_queue restored(local_allocator.get(), list_allocator.get());
+  restored.push(100);
+  ASSERT_TRUE(restored.deserialize(image).has_value());
+  EXPECT_EQ(restored.size(), ring_buffer_capacity * 2 + 1);
+}
+
+// ============================================================================
+// Spare Ring Buffers
+// ============================================================================
+
+// Heap-backed allocator that counts the blocks it hands out and takes back
+struct counting_allocator : simple_test_allocator {
+  inline static size_t allocations = 0;
+  inline static size_t deallocations = 0;
+
+  result<pointer_type> allocate_block() noexcept {
+    ++allocations;
+    return simple_test_allocator::allocate_block();
+  }
+
+  result<> deallocate_block(pointer_type ptr) noexcept {
+    ++deallocations;
+    return simple_test_allocator::deallocate_block(ptr);
+  }
+};
+
+constexpr size_t spare_ring_buffers = 2;
+using spare_queue = queue<int, ring_buffer_capacity, counting_allocator,
+                          counting_allocator, void, spare_ring_buffers>;
+
+static_assert(sizeof(spare_queue) == sizeof(test_queue),
+              "spares must not be stored in the queue");
+
+class SpareQueueTest : public ::testing::Test {
+protected:
+  counting_allocator local_allocator;
+  counting_allocator list_allocator;
+  spare_queue q{&local_allocator, &list_allocator};
+
+  void SetUp() override {
+    counting_allocator::allocations = 0;
+    counting_allocator::deallocations = 0;
+  }
+};
+
+TEST_F(SpareQueueTest, BoundaryOscillationReusesRingBuffers) {
+  q.push(0);
+  ASSERT_TRUE(q.pop().has_value());
+  EXPECT_EQ(spare_queue::spare_count(), 1);
+
+  size_t allocations = counting_allocator::allocations;
+  for (int i = 0; i < 100; ++i) {
+    q.push(i);
+    EXPECT_EQ(*q.pop(), i);
+  }
+
+  EXPECT_EQ(counting_allocator::allocations, allocations);
+  EXPECT_EQ(counting_allocator::deallocations, 0);
+}
+
+TEST_F(SpareQueueTest, ReusedRingBuffersStartEmpty) {
+  for (int i = 0; i < ring_buffer_capacity + 1; ++i) {
+    q.push(i);
+  }
+  for (int i = 0; i < ring_buffer_capacity + 1; ++i) {
+    EXPECT_EQ(*q.pop(), i);
+  }
+
+  std::vector<int> values(ring_buffer_capacity * 2);
+  for (int i = 0; i < static_cast<int>(values.size()); ++i) {
+    values[i] = 100 + i;
+  }
+  ASSERT_TRUE(q.push_range(values).has_value());
+
+  // A reset ring_buffer hands out its storage as one contiguous run again
+  EXPECT_EQ(q.peek()->size(), ring_buffer_capacity);
+  for (int value : values) {
+    EXPECT_EQ(*q.pop(), value);
+  }
+  EXPECT_TRUE(q.empty());
+}
+
+TEST_F(SpareQueueTest, RetainsAtMostConfiguredSpares) {
+  for (int i = 0; i < ring_buffer_capacity * 5; ++i) {
+    q.push(i);
+  }
+  for (int i = 0; i < ring_buffer_capacity * 5; ++i) {
+    q.pop();
+  }
+
+  EXPECT_EQ(spare_queue::spare_count(), spare_ring_buffers);
+  // Each ring_buffer takes a node block and a storage block
+  EXPECT_EQ(counting_allocator::deallocations,
+            2 * (5 - spare_ring_buffers));
+}
+
+TEST_F(SpareQueueTest, BackOscillationReusesRingBuffers) {
+  for (int i = 0; i < ring_buffer_capacity; ++i) {
+    q.push(i);
+  }
+  q.push(ring_buffer_capacity);
+  q.pop_back();
+  EXPECT_EQ(spare_queue::spare_count(), 1);
+
+  // Retrying at the front of a full ring_buffer reuses the spare as well
+  size_t allocations = counting_allocator::allocations;
+  for (int i = 0; i < 100; ++i) {
+    q.push(i);
+    EXPECT_EQ(*q.pop_back(), i);
+    q.push_front(i);
+    EXPECT_EQ(*q.pop(), i);
+  }
+
+  EXPECT_EQ(counting_allocator::allocations, allocations);
+  EXPECT_EQ(counting_allocator::deallocations, 0);
+}
+
+TEST_F(SpareQueueTest, SpliceBackDoesNotTouchAllocators) {
+  spare_queue other{&local_allocator, &list_allocator};
+  for (int i = 0; i < ring_buffer_capacity * 3; ++i) {
+    other.push(i);
+  }
+
+  size_t allocations = counting_allocator::allocations;
+  ASSERT_TRUE(q.splice_back(other).has_value());
+  EXPECT_EQ(counting_allocator::allocations, allocations);
+  EXPECT_EQ(counting_allocator::deallocations, 0);
+  EXPECT_EQ(q.size(), ring_buffer_capacity * 3);
+}
+
+TEST_F(SpareQueueTest, AbandonedReservationKeepsSpares) {
+  auto reservation = q.reserve_write(ring_buffer_capacity * 2);
+  ASSERT_TRUE(reservation.has_value());
+  ASSERT_TRUE(q.commit_write(*reservation, 0).has_value());
+  EXPECT_TRUE(q.empty());
+  EXPECT_EQ(spare_queue::spare_count(), spare_ring_buffers);
+  EXPECT_EQ(counting_allocator::deallocations, 0);
+
+  // The next reservation is served from the spares
+  size_t allocations = counting_allocator::allocations;
+  auto again = q.reserve_write(ring_buffer_capacity * 2);
+  ASSERT_TRUE(again.has_value());
+  for (std::span<int> chunk : *again) {
+    std::fill(chunk.begin(), chunk.end(), 7);
+  }
+  ASSERT_TRUE(q.commit_write(*again, 1).has_value());
+  EXPECT_EQ(counting_allocator::allocations, allocations);
+  EXPECT_EQ(counting_allocator::deallocations, 0);
+  EXPECT_EQ(spare_queue::spare_count(), 1);
+  EXPECT_EQ(*q.pop(), 7);
+}
+
+TEST_F(SpareQueueTest, SparesDoNotCarryOverToNewAllocators) {
+  q.push(0);
+  ASSERT_TRUE(q.pop().has_value());
+  ASSERT_EQ(spare_queue::spare_count(), 1);
+
+  // A second set of allocators, while the first is still in use
+  counting_allocator other_local;
+  counting_allocator other_list;
+  spare_queue other{&other_local, &other_list};
+
+  // The spare went back to the allocators it came from: its node and its
+  // ring_buffer storage
+  EXPECT_EQ(spare_queue::spare_count(), 0);
+  EXPECT_EQ(counting_allocator::deallocations, 2);
+
+  size_t allocations = counting_allocator::allocations;
+  other.push(1);
+  EXPECT_EQ(counting_allocator::allocations, allocations + 2);
+  EXPECT_EQ(**other.front(), 1);
+}
+
+TEST(SpareQueueLifetimeTest, LastQueueReleasesSpares) {
+  {
+    counting_allocator local_allocator;
+    counting_allocator list_allocator;
+    spare_queue first{&local_allocator, &list_allocator};
+    spare_queue second{&local_allocator, &list_allocator};
+    first.push(0);
+    ASSERT_TRUE(first.pop().has_value());
+
+    size_t deallocations = counting_allocator::deallocations;
+    { spare_queue moved(std::move(first)); }
+    // second is still alive and may reuse the spare
+    EXPECT_EQ(spare_queue::spare_count(), 1);
+    EXPECT_EQ(counting_allocator::deallocations, deallocations);
+  }
+
+  // No spare survives its allocators
+  EXPECT_EQ(spare_queue::spare_count(), 0);
+}
+
+TEST_F(SpareQueueTest, ShrinkToFitReleasesSpares) {
+  for (int i = 0; i < ring_buffer_capacity * 2; ++i) {
+    q.push(i);
+  }
+  for (int i = 0; i < ring_buffer_capacity * 2; ++i) {
+    q.pop();
+  }
+  ASSERT_EQ(spare_queue::spare_count(), spare_ring_buffers);
+
+  spare_queue::shrink_to_fit();
+  EXPECT_EQ(spare_queue::spare_count(), 0);
+  EXPECT_EQ(counting_allocator::deallocations,
+            counting_allocator::allocations);
+}
+
+// ============================================================================
+// Move and Swap
+// ============================================================================
+
+using counting_queue =
+    queue<int, ring_buffer_capacity, counting_allocator, counting_allocator>;
+
+class MoveQueueTest : public ::testing::Test {
+protected:
+  counting_allocator local_allocator;
+  counting_allocator list_allocator;
+
+  counting_queue make_filled(int count) {
+    counting_queue q{&local_allocator, &list_allocator};
+    for (int i = 0; i < count; ++i) {
+      q.push(i);
+    }
+    return q;
+  }
+
+  void SetUp() override {
+    counting_allocator::allocations = 0;
+    counting_allocator::deallocations = 0;
+  }
+};
+
+TEST_F(MoveQueueTest, MoveConstructionTransfersChain) {
+  counting_queue source = make_filled(ring_buffer_capacity * 3);
+  size_t allocations = counting_allocator::allocations;
+
+  counting_queue target(std::move(source));
+
+  EXPECT_EQ(counting_allocator::allocations, allocations);
+  EXPECT_EQ(counting_allocator::deallocations, 0);
+  EXPECT_TRUE(source.empty());
+  EXPECT_EQ(target.size(), ring_buffer_capacity * 3);
+  for (int i = 0; i < ring_buffer_capacity * 3; ++i) {
+    EXPECT_EQ(*target.pop(), i);
+  }
+
+  // The moved-from queue is usable
+  source.push(7);
+  EXPECT_EQ(*source.pop(), 7);
+}
+
+TEST_F(MoveQueueTest, MoveAssignmentReleasesOldElements) {
+  counting_queue source = make_filled(ring_buffer_capacity * 2);
+  counting_queue target = make_filled(1);
+  size_t allocations = counting_allocator::allocations;
+
+  target = std::move(source);
+
+  // Only target's own ring_buffer (node and storage) is released
+  EXPECT_EQ(counting_allocator::allocations, allocations);
+  EXPECT_EQ(counting_allocator::deallocations, 2);
+  EXPECT_TRUE(source.empty());
+  EXPECT_EQ(target.size(), ring_buffer_capacity * 2);
+  EXPECT_EQ(*target.front(), 0);
+}
+
+TEST_F(MoveQueueTest, SwapExchangesChains) {
+  counting_queue a = make_filled(ring_buffer_capacity + 1);
+  counting_queue b = make_filled(2);
+  size_t allocations = counting_allocator::allocations;
+
+  a.swap(b);
+
+  EXPECT_EQ(counting_allocator::allocations, allocations);
+  EXPECT_EQ(counting_allocator::deallocations, 0);
+  EXPECT_EQ(a.size(), 2);
+  EXPECT_EQ(b.size(), ring_buffer_capacity + 1);
+  EXPECT_EQ(*b.back(), static_cast<int>(ring_buffer_capacity));
+}
+
+TEST_F(MoveQueueTest, QueuesLiveInVector) {
+  std::vector<counting_queue> queues;
+  for (int i = 0; i < 16; ++i) {
+    queues.push_back(make_filled(ring_buffer_capacity + i));
+  }
+  // Vector growth relocated the queues by moving them
+  EXPECT_EQ(counting_allocator::deallocations, 0);
+
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_EQ(queues[i].size(), ring_buffer_capacity + i);
+    EXPECT_EQ(*queues[i].back(),
+              static_cast<int>(ring_buffer_capacity) + i - 1);
+  }
+}
+
+TEST_F(MoveQueueTest, CountedQueueMovesItsCount) {
+  using counted_counting_queue = queue<int, ring_buffer_capacity,
+                                       counting_allocator, counting_allocator,
+                                       uint16_t>;
+  counted_counting_queue source{&local_allocator, &list_allocator};
+  source.push(1);
+  source.push(2);
+
+  counted_counting_queue target(std::move(source));
+  EXPECT_EQ(target.size(), 2);
+  EXPECT_EQ(source.size(), 0);
+}
+
+// ============================================================================
+// Per-Thread Allocator Context
+// ============================================================================
+
+TEST(PerThreadQueueTest, EachThreadRunsItsOwnArenas) {
+  using thread_local_alloc = per_thread_local_buffer(16, 128);
+  using thread_list_alloc = per_thread_growing_pool(8, 32, thread_local_alloc);
+  using thread_queue =
+      queue<int, ring_buffer_capacity, thread_local_alloc, thread_list_alloc>;
+
+  constexpr int threads = 4;
+  constexpr int count = ring_buffer_capacity * 10;
+  std::latch constructed(threads);
+  std::array<bool, threads> in_order{};
+
+  auto run = [&](int t) {
+    auto local = std::make_unique<thread_local_alloc>();
+    auto list = std::make_unique<thread_list_alloc>(local.get());
+    thread_queue q(local.get(), list.get());
+    // Every thread's arenas exist before any thread uses its queue
+    constructed.arrive_and_wait();
+
+    bool ok = true;
+    for (int round = 0; round < 10; ++round) {
+      for (int i = 0; i < count; ++i) {
+        ok = ok && q.push(t * count + i).has_value();
+      }
+      for (int i = 0; i < count; ++i) {
+        ok = ok && q.pop().value_or(-1) == t * count + i;
+      }
+    }
+    in_order[t] = ok && q.empty();
+  };
+
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back(run, t);
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  for (bool ok : in_order) {
+    EXPECT_TRUE(ok);
+  }
+}
+
+// ============================================================================
+// Persistent Queues in a Mapped Arena
+// ============================================================================
+
+using persistent_arena = mapped_buffer(64, 128);
+using persistent_list_pool = growing_pool(8, 32, persistent_arena);
+using persistent_queue =
+    queue<int, 8, persistent_arena, persistent_list_pool, uint16_t>;
+
+// Everything a restarted process needs, kept in one rooted arena block
+struct persistent_root {
+  persistent_list_pool::checkpoint_type pool;
+  alignas(persistent_queue) std::byte queue[sizeof(persistent_queue)];
+
+  persistent_queue *get() noexcept {
+    return std::launder(reinterpret_cast<persistent_queue *>(queue));
+  }
+};
+static_assert(sizeof(persistent_root) <= persistent_arena::block_size);
+
+TEST(PersistentQueueTest, QueueSurvivesRestartWithoutReplay) {
+  std::string path = ::testing::TempDir() + "persistent_queue_arena";
+  std::remove(path.c_str());
+  constexpr int count = 100;
+
+  {
+    auto opened = persistent_arena::open(path.c_str());
+    ASSERT_TRUE(opened.has_value());
+    auto &arena = *opened;
+    auto pool = std::make_unique<persistent_list_pool>(arena.get());
+
+    auto root_block = *arena->allocate_block();
+    auto *root = new (static_cast<void *>(root_block)) persistent_root{};
+    auto *q = new (root->queue) persistent_queue(arena.get(), pool.get());
+    for (int i = 0; i < count; ++i) {
+      ASSERT_TRUE(q->push(i).has_value());
+    }
+
+    // Shut down without destroying the queue, its ring_buffers stay in the
+    // file
+    root->pool = pool->release();
+    arena->set_root(0, root_block);
+  }
+
+  auto reopened = persistent_arena::open(path.c_str());
+  ASSERT_TRUE(reopened.has_value());
+  auto &arena = *reopened;
+  ASSERT_TRUE(arena->recovered());
+
+  auto *root = std::launder(
+      static_cast<persistent_root *>(static_cast<void *>(arena->root(0))));
+  auto pool = std::make_unique<persistent_list_pool>(arena.get(), root->pool);
+  persistent_queue::attach(arena.get(), pool.get());
+
+  persistent_queue *q = root->get();
+  EXPECT_EQ(q->size(), count);
+  for (int i = 0; i < count; ++i) {
+    EXPECT_EQ(*q->pop(), i);
+  }
+  ASSERT_TRUE(q->push(7).has_value());
+  EXPECT_EQ(*q->front(), 7);
+
+  q->~persistent_queue();
+  pool.reset();
+  arena.reset();
+  std::remove(path.c_str());
+}
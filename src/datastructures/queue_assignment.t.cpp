@@ -24,6 +24,15 @@ using byte_queue =
 static_assert(sizeof(byte_queue) <= queue_object_pool::block_size,
               "Queue size exceeds allocator block size");
 
+// An O(1) size counter costs exactly its own width on top of the list's head,
+// tail and count; a one byte counter still fits the 4 byte budget
+using counted_byte_queue = queue<unsigned char, RING_BUFFER_CAPACITY,
+                                 local_alloc, list_node_pool, uint8_t>;
+static_assert(sizeof(counted_byte_queue) == sizeof(byte_queue) + 1,
+              "Size counter adds more than its own width");
+static_assert(sizeof(counted_byte_queue) <= queue_object_pool::block_size,
+              "Counted queue size exceeds allocator block size");
+
 // Test fixture that manages shared allocators for multiple queues
 class QueueAssignmentTest : public ::testing::Test {
 protected:
@@ -47,6 +56,9 @@ protected:
   }
 
   void TearDown() override {
+    // Limits are shared by every byte_queue
+    byte_queue::set_limits({});
+
     // Destroy all queues - must call destructor and deallocate
     for (auto *q : queues) {
       q->~byte_queue();
@@ -483,3 +495,137 @@ TEST_F(QueueAssignmentTest, EmptyQueueAfterClear) {
 
   destroy_queue(q);
 }
+
+TEST_F(QueueAssignmentTest, CompactReclaimsSplicedBursts) {
+  // Sixteen small bursts spliced together occupy sixteen ring_buffers, each
+  // holding its own 16-byte block of the shared 2KB pool
+  constexpr size_t BURSTS = 16;
+  constexpr size_t BURST_BYTES = 3;
+
+  byte_queue *q = create_queue();
+  for (size_t burst = 0; burst < BURSTS; ++burst) {
+    byte_queue *staging = create_queue();
+    for (size_t i = 0; i < BURST_BYTES; ++i) {
+      enqueue_byte(staging,
+                   static_cast<unsigned char>(burst * BURST_BYTES + i));
+    }
+    ASSERT_TRUE(q->splice_back(*staging).has_value());
+    destroy_queue(staging);
+  }
+
+  // Run compaction in small steps, as an idle hook would
+  size_t freed = 0;
+  do {
+    freed += q->compact(8);
+  } while (q->compacting());
+  // 48 bytes end up in ring_buffers of 15, 15, 15 and 3
+  EXPECT_EQ(freed, 12);
+
+  EXPECT_EQ(q->size(), BURSTS * BURST_BYTES);
+  for (size_t i = 0; i < BURSTS * BURST_BYTES; ++i) {
+    EXPECT_EQ(dequeue_byte(q), static_cast<unsigned char>(i));
+  }
+
+  destroy_queue(q);
+}
+
+// ============================================================================
+// Flow Control Tests
+// ============================================================================
+
+TEST_F(QueueAssignmentTest, QuotaPushesBackRunawayQueue) {
+  byte_queue::set_limits({.max_ring_buffers = 4});
+
+  byte_queue *runaway = create_queue();
+  size_t pushed = 0;
+  for (;;) {
+    auto result = runaway->push(static_cast<unsigned char>(pushed));
+    if (!result.has_value()) {
+      EXPECT_EQ(result.error(), error::backpressure);
+      break;
+    }
+    ++pushed;
+  }
+  EXPECT_EQ(pushed, 4 * RING_BUFFER_CAPACITY);
+  EXPECT_EQ(runaway->size(), pushed);
+
+  // Other queues keep their own quota
+  byte_queue *other = create_queue();
+  enqueue_byte(other, 1);
+  EXPECT_EQ(dequeue_byte(other), 1);
+
+  // Draining a ring_buffer makes room again
+  for (size_t i = 0; i < RING_BUFFER_CAPACITY; ++i) {
+    dequeue_byte(runaway);
+  }
+  EXPECT_TRUE(runaway->push(0).has_value());
+
+  destroy_queue(other);
+  destroy_queue(runaway);
+}
+
+TEST_F(QueueAssignmentTest, ReserveKeepsHeadroomForSmallQueues) {
+  constexpr size_t SMALL_QUEUES = 3;
+  byte_queue::set_limits(
+      {.reserve_blocks = 16, .small_queue_ring_buffers = 2});
+
+  // Without the reserve this queue would run the arena into the OOM
+  // callback, which aborts
+  byte_queue *runaway = create_queue();
+  size_t pushed = 0;
+  while (runaway->push(static_cast<unsigned char>(pushed)).has_value()) {
+    ++pushed;
+  }
+  EXPECT_GE(pushed, 50 * RING_BUFFER_CAPACITY);
+  EXPECT_LE(local_allocator->available(), 16);
+
+  // Small queues may still grow to two ring_buffers each
+  std::vector<byte_queue *> small;
+  for (size_t i = 0; i < SMALL_QUEUES; ++i) {
+    small.push_back(create_queue());
+    ASSERT_NE(small.back(), nullptr);
+    for (size_t b = 0; b < 2 * RING_BUFFER_CAPACITY; ++b) {
+      enqueue_byte(small.back(), static_cast<unsigned char>(b));
+    }
+    auto result = small.back()->push(0);
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(result.error(), error::backpressure);
+  }
+
+  for (auto *q : small) {
+    EXPECT_EQ(q->size(), 2 * RING_BUFFER_CAPACITY);
+    destroy_queue(q);
+  }
+  destroy_queue(runaway);
+}
+
+TEST_F(QueueAssignmentTest, WatermarksFireOncePerCrossing) {
+  size_t highs = 0;
+  size_t lows = 0;
+  byte_queue::set_limits({.high_watermark = 64,
+                          .low_watermark = 32,
+                          .on_high = [&] { ++highs; },
+                          .on_low = [&] { ++lows; }});
+
+  byte_queue *q = create_queue();
+  for (size_t i = 0; i < 1000; ++i) {
+    enqueue_byte(q, static_cast<unsigned char>(i));
+  }
+  EXPECT_EQ(highs, 1);
+  EXPECT_EQ(lows, 0);
+
+  // Falling below the high watermark is not enough, usage must reach the
+  // low watermark
+  for (size_t i = 0; i < 1000; ++i) {
+    dequeue_byte(q);
+  }
+  EXPECT_EQ(highs, 1);
+  EXPECT_EQ(lows, 1);
+
+  for (size_t i = 0; i < 1000; ++i) {
+    enqueue_byte(q, static_cast<unsigned char>(i));
+  }
+  EXPECT_EQ(highs, 2);
+
+  destroy_queue(q);
+}
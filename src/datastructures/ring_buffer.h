@@ -1,15 +1,28 @@
 #pragma once
 #include <allocators/test_allocator.h>
+#include <algorithm>
+#include <array>
 #include <compare>
 #include <cstddef>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <utility>
 #include <iterators/container_interface.h>
 #include <iterators/iterator_facade.h>
 #include <types.h>
 
-template <typename allocator_type> struct ring_buffer_allocator_storage {
+template <typename allocator_type,
+          bool = per_thread_allocator<allocator_type>>
+struct ring_buffer_allocator_storage {
   inline static allocator_type *_allocator{nullptr};
 };
 
+template <typename allocator_type>
+struct ring_buffer_allocator_storage<allocator_type, true> {
+  inline static thread_local allocator_type *_allocator{nullptr};
+};
+
 // Fixed-capacity circular buffer
 template <is_nothrow T, std::size_t max_element_count,
           is_homogenous allocator_type = simple_test_allocator>
@@ -53,6 +66,47 @@ private:
     ++_free;
   }
 
+  constexpr void retreat_head() noexcept {
+    _head = (_head + max_element_count - 1) % max_element_count;
+    --_free;
+  }
+
+  constexpr void retreat_tail() noexcept {
+    _tail = (_tail + max_element_count - 1) % max_element_count;
+    ++_free;
+  }
+
+  constexpr void advance_tail(size_type n) noexcept {
+    _tail = (_tail + n) % max_element_count;
+    _free -= n;
+  }
+
+  constexpr void advance_head(size_type n) noexcept {
+    _head = (_head + n) % max_element_count;
+    _free += n;
+  }
+
+  // Copy-construct a contiguous run into uninitialized slots
+  static void copy_run(const T *src, size_t n, T *dst) noexcept {
+    if (n == 0) { return; }
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      std::memcpy(static_cast<void *>(dst), src, n * sizeof(T));
+    } else {
+      std::uninitialized_copy_n(src, n, dst);
+    }
+  }
+
+  // Move a contiguous run out of the buffer, leaving its slots uninitialized
+  static void move_run(T *src, size_t n, T *dst) noexcept {
+    if (n == 0) { return; }
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      std::memcpy(static_cast<void *>(dst), src, n * sizeof(T));
+    } else {
+      std::move(src, src + n, dst);
+      std::destroy_n(src, n);
+    }
+  }
+
 public:
   ring_buffer() : ring_buffer(&default_allocator) {}
 
@@ -65,6 +119,13 @@ public:
     _storage = *result;
   }
 
+  // Point ring_buffers of this type at alloc without constructing one, for
+  // ring_buffers recovered from a file-backed arena
+  static void attach(allocator_type *alloc) noexcept {
+    fatal(alloc == nullptr, "Allocator cannot be null");
+    storage::_allocator = alloc;
+  }
+
   ~ring_buffer() {
     clear();
 
@@ -85,8 +146,33 @@ public:
   }
 
   ring_buffer &operator=(const ring_buffer &) = delete;
-  ring_buffer(ring_buffer &&) noexcept = delete;
-  ring_buffer &operator=(ring_buffer &&) noexcept = delete;
+
+  // Takes over other's storage and elements. The moved-from ring_buffer has
+  // no storage and may only be destroyed or assigned to.
+  ring_buffer(ring_buffer &&other) noexcept
+      : _head(std::exchange(other._head, 0)),
+        _tail(std::exchange(other._tail, 0)),
+        _free(std::exchange(other._free, max_element_count)),
+        _storage(std::exchange(
+            other._storage, typename allocator_type::pointer_type(nullptr))) {
+  }
+
+  // Destroys this buffer's elements and swaps storage, so other keeps the
+  // emptied storage and neither side calls the allocator
+  ring_buffer &operator=(ring_buffer &&other) noexcept {
+    if (this != &other) {
+      clear();
+      swap(other);
+    }
+    return *this;
+  }
+
+  void swap(ring_buffer &other) noexcept {
+    std::swap(_head, other._head);
+    std::swap(_tail, other._tail);
+    std::swap(_free, other._free);
+    std::swap(_storage, other._storage);
+  }
 
   void clear() noexcept {
     while (!empty()) {
@@ -95,6 +181,14 @@ public:
     }
   }
 
+  // Clear and rewind to the start of the storage, so the next writes are
+  // contiguous again
+  void reset() noexcept {
+    clear();
+    _head = 0;
+    _tail = 0;
+  }
+
   // Push element to the back (tail) of the ring buffer.
   template <typename U>
     requires std::same_as<std::remove_cvref_t<U>, T>
@@ -124,6 +218,124 @@ public:
     return value;
   }
 
+  // Push element to the front, before the oldest one.
+  template <typename U>
+    requires std::same_as<std::remove_cvref_t<U>, T>
+  constexpr result<> push_front(U &&value) {
+    fail(is_full(), "Cannot push_front to full ring_buffer");
+    retreat_head();
+    new (construction_location(_head)) T(std::forward<U>(value));
+    return {};
+  }
+
+  // Construct element in-place at the front.
+  template <typename... Args> constexpr T &emplace_front(Args &&...args) {
+    fatal(is_full(), "Cannot emplace_front in full ring_buffer");
+    retreat_head();
+    return *new (construction_location(_head)) T(std::forward<Args>(args)...);
+  }
+
+  // Pop element from the back (newest) of the ring buffer.
+  constexpr result<T> pop_back() {
+    fail(empty(), "Cannot pop_back from empty ring_buffer");
+    retreat_tail();
+    T *ptr = storage_ptr() + _tail;
+    T value = std::move(*ptr);
+    ptr->~T();
+    return value;
+  }
+
+  // Push as many leading elements of values as fit, in at most two contiguous
+  // runs (tail to end of storage, then start of storage). Returns the number
+  // of elements pushed.
+  size_type push_range(std::span<const T> values) noexcept {
+    auto count = static_cast<size_type>(std::min<size_t>(values.size(), _free));
+    auto first = std::min<size_t>(count, max_element_count - _tail);
+
+    T *base = storage_ptr();
+    copy_run(values.data(), first, base + _tail);
+    copy_run(values.data() + first, count - first, base);
+    advance_tail(count);
+    return count;
+  }
+
+  // Pop up to out.size() elements into out, in at most two contiguous runs.
+  // Returns the number of elements popped.
+  size_type pop_n(std::span<T> out) noexcept {
+    auto count = static_cast<size_type>(std::min<size_t>(out.size(), size()));
+    auto first = std::min<size_t>(count, max_element_count - _head);
+
+    T *base = storage_ptr();
+    move_run(base + _head, first, out.data());
+    move_run(base, count - first, out.data() + first);
+    advance_head(count);
+    return count;
+  }
+
+  // Move up to n of other's oldest elements to the back, in contiguous runs
+  // when T is trivially copyable. Returns the number of elements moved.
+  size_type take_front(ring_buffer &other, size_type n) noexcept {
+    n = std::min(n, std::min(other.size(), _free));
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      size_type moved = 0;
+      while (moved < n) {
+        auto run = other.read_spans()[0];
+        run = run.first(std::min<size_t>(run.size(), n - moved));
+        auto pushed = push_range(run);
+        other.consume(pushed);
+        moved += pushed;
+      }
+    } else {
+      for (size_type i = 0; i < n; ++i) {
+        emplace(std::move(other.front()));
+        other.consume(1);
+      }
+    }
+    return n;
+  }
+
+  // Readable elements as up to two contiguous chunks (head to end of storage,
+  // then start of storage); the second chunk is empty unless the data wraps.
+  std::array<std::span<const T>, 2> read_spans() const noexcept {
+    const T *base = storage_ptr();
+    auto first = std::min<size_t>(size(), max_element_count - _head);
+    return {std::span<const T>(base + _head, first),
+            std::span<const T>(base, size() - first)};
+  }
+
+  // Free slots as up to two contiguous chunks (tail to end of storage, then
+  // start of storage), to be filled in place and published with commit().
+  std::array<std::span<T>, 2> write_spans() noexcept
+    requires std::is_trivially_copyable_v<T>
+  {
+    T *base = storage_ptr();
+    auto first = std::min<size_t>(_free, max_element_count - _tail);
+    return {std::span<T>(base + _tail, first),
+            std::span<T>(base, _free - first)};
+  }
+
+  // Publish the n oldest free slots, filled through write_spans(), as
+  // elements.
+  void commit(size_type n) noexcept
+    requires std::is_trivially_copyable_v<T>
+  {
+    fatal(n > _free, "ring_buffer::commit: count exceeds free slots");
+    advance_tail(n);
+  }
+
+  // Destroy the n oldest elements in place, without moving them out.
+  void consume(size_type n) noexcept {
+    fatal(n > size(), "ring_buffer::consume: count exceeds size");
+    if constexpr (std::is_trivially_destructible_v<T>) {
+      advance_head(n);
+    } else {
+      for (size_type i = 0; i < n; ++i) {
+        (storage_ptr() + _head)->~T();
+        advance_head();
+      }
+    }
+  }
+
   // Access front element (oldest).
   auto &&front(this auto &&self) {
     fatal(self.empty(), "front() called on empty ring_buffer");
@@ -181,8 +393,16 @@ public:
 
   void advance(difference_type n) noexcept {
     auto new_pos = (static_cast<difference_type>(_pos) + n);
-    new_pos %= static_cast<difference_type>(count);
-    if (new_pos < 0) { new_pos += count; }
+    // Steps within one lap, ++ and -- among them, wrap without a division
+    if (new_pos >= static_cast<difference_type>(count)) {
+      new_pos -= count;
+    } else if (new_pos < 0) {
+      new_pos += count;
+    }
+    if (new_pos < 0 || new_pos >= static_cast<difference_type>(count)) {
+      new_pos %= static_cast<difference_type>(count);
+      if (new_pos < 0) { new_pos += count; }
+    }
     _pos = static_cast<size_type>(new_pos);
   }
 
@@ -190,6 +190,135 @@ TEST_F(RingBufferTest, WrapsAroundCorrectly) {
   EXPECT_TRUE(buffer->empty());
 }
 
+// ============================================================================
+// Bulk Operations
+// ============================================================================
+
+TEST_F(RingBufferTest, PushRangeStopsWhenFull) {
+  std::vector<int> values(ring_buffer_capacity + 3);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = static_cast<int>(i);
+  }
+
+  EXPECT_EQ(buffer->push_range(values), ring_buffer_capacity);
+  EXPECT_TRUE(buffer->is_full());
+  EXPECT_EQ(buffer->front(), 0);
+  EXPECT_EQ(buffer->back(), static_cast<int>(ring_buffer_capacity - 1));
+}
+
+TEST_F(RingBufferTest, PushRangeWrapsAround) {
+  for (size_t i = 0; i < ring_buffer_capacity - 2; ++i) {
+    buffer->push(static_cast<int>(i));
+  }
+  for (size_t i = 0; i < ring_buffer_capacity - 2; ++i) {
+    buffer->pop();
+  }
+
+  // tail is two slots before the end, so this splits into two runs
+  std::vector<int> values = {10, 11, 12, 13, 14};
+  EXPECT_EQ(buffer->push_range(values), values.size());
+
+  for (int value : values) {
+    EXPECT_EQ(*buffer->pop(), value);
+  }
+  EXPECT_TRUE(buffer->empty());
+}
+
+TEST_F(RingBufferTest, PopNWrapsAround) {
+  for (size_t i = 0; i < ring_buffer_capacity; ++i) {
+    buffer->push(static_cast<int>(i));
+  }
+  for (size_t i = 0; i < ring_buffer_capacity - 2; ++i) {
+    buffer->pop();
+  }
+  buffer->push(100);
+  buffer->push(101);
+
+  std::vector<int> out(ring_buffer_capacity);
+  EXPECT_EQ(buffer->pop_n(out), 4);
+  EXPECT_EQ(out[0], static_cast<int>(ring_buffer_capacity - 2));
+  EXPECT_EQ(out[1], static_cast<int>(ring_buffer_capacity - 1));
+  EXPECT_EQ(out[2], 100);
+  EXPECT_EQ(out[3], 101);
+  EXPECT_TRUE(buffer->empty());
+}
+
+TEST_F(RingBufferTest, PopNStopsAtOutputSize) {
+  buffer->push(1);
+  buffer->push(2);
+  buffer->push(3);
+
+  std::vector<int> out(2);
+  EXPECT_EQ(buffer->pop_n(out), 2);
+  EXPECT_EQ(out[0], 1);
+  EXPECT_EQ(out[1], 2);
+  EXPECT_EQ(buffer->size(), 1);
+  EXPECT_EQ(buffer->front(), 3);
+}
+
+// ============================================================================
+// Read Spans / Consume
+// ============================================================================
+
+TEST_F(RingBufferTest, ReadSpansEmptyBuffer) {
+  auto spans = buffer->read_spans();
+  EXPECT_TRUE(spans[0].empty());
+  EXPECT_TRUE(spans[1].empty());
+}
+
+TEST_F(RingBufferTest, ReadSpansSplitOnWrapAround) {
+  for (size_t i = 0; i < ring_buffer_capacity; ++i) {
+    buffer->push(static_cast<int>(i));
+  }
+  for (size_t i = 0; i < ring_buffer_capacity - 2; ++i) {
+    buffer->pop();
+  }
+  buffer->push(100);
+
+  auto spans = buffer->read_spans();
+  ASSERT_EQ(spans[0].size(), 2);
+  ASSERT_EQ(spans[1].size(), 1);
+  EXPECT_EQ(spans[0][0], static_cast<int>(ring_buffer_capacity - 2));
+  EXPECT_EQ(spans[0][1], static_cast<int>(ring_buffer_capacity - 1));
+  EXPECT_EQ(spans[1][0], 100);
+  EXPECT_EQ(&spans[0][0], &buffer->front());
+}
+
+TEST_F(RingBufferTest, ConsumeDiscardsOldest) {
+  buffer->push(1);
+  buffer->push(2);
+  buffer->push(3);
+
+  buffer->consume(2);
+  EXPECT_EQ(buffer->size(), 1);
+  EXPECT_EQ(buffer->front(), 3);
+
+  buffer->consume(1);
+  EXPECT_TRUE(buffer->empty());
+}
+
+TEST_F(RingBufferTest, WriteSpansCommit) {
+  for (size_t i = 0; i < ring_buffer_capacity - 1; ++i) {
+    buffer->push(static_cast<int>(i));
+  }
+  for (size_t i = 0; i < ring_buffer_capacity - 2; ++i) {
+    buffer->pop();
+  }
+
+  // One free slot before the end of storage, the rest wraps to the start
+  auto spans = buffer->write_spans();
+  ASSERT_EQ(spans[0].size(), 1);
+  ASSERT_EQ(spans[1].size(), ring_buffer_capacity - 2);
+  spans[0][0] = 100;
+  spans[1][0] = 101;
+
+  buffer->commit(2);
+  EXPECT_EQ(buffer->size(), 3);
+  EXPECT_EQ(*buffer->pop(), static_cast<int>(ring_buffer_capacity - 2));
+  EXPECT_EQ(*buffer->pop(), 100);
+  EXPECT_EQ(*buffer->pop(), 101);
+}
+
 // ============================================================================
 // Clear
 // ============================================================================
@@ -259,3 +388,73 @@ TEST_F(RingBufferTest, MovesElementsCorrectly) {
   buffer->push(std::move(42)); // Move rvalue
   EXPECT_EQ(buffer->front(), 42);
 }
+
+TEST_F(RingBufferTest, MoveConstructionTakesStorage) {
+  buffer->push(1);
+  buffer->push(2);
+  const int *storage = buffer->read_spans()[0].data();
+
+  test_ring_buffer moved(std::move(*buffer));
+
+  EXPECT_EQ(moved.read_spans()[0].data(), storage);
+  EXPECT_EQ(moved.size(), 2);
+  EXPECT_EQ(moved.front(), 1);
+  EXPECT_TRUE(buffer->empty());
+}
+
+TEST_F(RingBufferTest, MoveAssignmentLeavesSourceUsable) {
+  test_ring_buffer other(&allocator);
+  other.push(5);
+  buffer->push(1);
+  const int *storage = other.read_spans()[0].data();
+
+  *buffer = std::move(other);
+
+  // Storage is swapped, so the source keeps the target's emptied storage
+  EXPECT_EQ(buffer->read_spans()[0].data(), storage);
+  EXPECT_EQ(buffer->size(), 1);
+  EXPECT_EQ(buffer->front(), 5);
+  EXPECT_TRUE(other.empty());
+  ASSERT_TRUE(other.push(6).has_value());
+  EXPECT_EQ(other.front(), 6);
+}
+
+TEST_F(RingBufferTest, SwapExchangesContents) {
+  test_ring_buffer other(&allocator);
+  other.push(5);
+  other.push(6);
+  buffer->push(1);
+
+  buffer->swap(other);
+
+  EXPECT_EQ(buffer->size(), 2);
+  EXPECT_EQ(buffer->front(), 5);
+  EXPECT_EQ(other.size(), 1);
+  EXPECT_EQ(other.front(), 1);
+}
+
+TEST_F(RingBufferTest, PushFrontWrapsBeforeHead) {
+  buffer->push(2);
+  ASSERT_TRUE(buffer->push_front(1).has_value());
+  buffer->emplace_front(0);
+
+  EXPECT_EQ(buffer->size(), 3);
+  EXPECT_EQ(buffer->front(), 0);
+  EXPECT_EQ(buffer->back(), 2);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(*buffer->pop(), i);
+  }
+}
+
+TEST_F(RingBufferTest, PopBackReturnsNewest) {
+  for (int i = 0; i < ring_buffer_capacity; ++i) {
+    buffer->push(i);
+  }
+  EXPECT_FALSE(buffer->push_front(-1).has_value());
+
+  for (int i = ring_buffer_capacity - 1; i >= 0; --i) {
+    EXPECT_EQ(*buffer->pop_back(), i);
+  }
+  EXPECT_TRUE(buffer->empty());
+  EXPECT_FALSE(buffer->pop_back().has_value());
+}
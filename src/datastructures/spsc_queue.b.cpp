@@ -0,0 +1,161 @@
+#include <benchmark/benchmark.h>
+#include <local_buffer.h>
+#include <locked_queue.h>
+#include <memory>
+#include <spsc_queue.h>
+
+// ============================================================================
+// Configuration
+// ============================================================================
+// Both queues move batches of ints from a producer thread (thread 0) to a
+// consumer thread (thread 1). The producer never runs more than max_in_flight
+// items ahead, which keeps the spsc_queue inside its local_buffer.
+// ============================================================================
+
+constexpr size_t batch_size = 1024;
+constexpr size_t max_in_flight = 32 * batch_size;
+
+constexpr size_t spsc_block_size = 4096;
+constexpr size_t spsc_block_count = 64;
+constexpr size_t spsc_segment_capacity = 1000;
+
+using spsc_alloc = local_buffer(spsc_block_size, spsc_block_count);
+using bench_spsc_queue = spsc_queue<int, spsc_segment_capacity, spsc_alloc>;
+
+// ============================================================================
+// Throughput
+// ============================================================================
+
+static std::unique_ptr<spsc_alloc> spsc_allocator;
+static std::unique_ptr<bench_spsc_queue> spsc;
+static std::unique_ptr<locked_queue> locked;
+
+template <typename queue_type>
+static void transfer(benchmark::State &state, queue_type &q) {
+  if (state.thread_index() == 0) {
+    int next = 0;
+    for (auto _ : state) {
+      while (q.size() > max_in_flight - batch_size) {}
+      for (size_t i = 0; i < batch_size; ++i) {
+        q.push(next++);
+      }
+    }
+  } else {
+    for (auto _ : state) {
+      for (size_t i = 0; i < batch_size;) {
+        if (q.pop()) { ++i; }
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+// Setup and teardown run once, before the threads start and after they join
+static void create_spsc(const benchmark::State &) {
+  spsc_allocator = std::make_unique<spsc_alloc>();
+  spsc = std::make_unique<bench_spsc_queue>(spsc_allocator.get());
+}
+
+static void destroy_spsc(const benchmark::State &) {
+  spsc.reset();
+  spsc_allocator.reset();
+}
+
+static void create_locked(const benchmark::State &) {
+  locked = std::make_unique<locked_queue>();
+}
+
+static void destroy_locked(const benchmark::State &) { locked.reset(); }
+
+static void BM_SpscThroughput(benchmark::State &state) {
+  transfer(state, *spsc);
+}
+BENCHMARK(BM_SpscThroughput)
+    ->Setup(create_spsc)
+    ->Teardown(destroy_spsc)
+    ->Threads(2)
+    ->UseRealTime();
+
+static void BM_LockedQueueThroughput(benchmark::State &state) {
+  transfer(state, *locked);
+}
+BENCHMARK(BM_LockedQueueThroughput)
+    ->Setup(create_locked)
+    ->Teardown(destroy_locked)
+    ->Threads(2)
+    ->UseRealTime();
+
+// ============================================================================
+// Round-Trip Latency
+// ============================================================================
+// Thread 0 sends a value and waits for thread 1 to echo it back. Each
+// spsc_queue has its own allocator type, since an allocator may only be used
+// by a single producer.
+// ============================================================================
+
+using reply_alloc = local_buffer(spsc_block_size, spsc_block_count);
+using reply_spsc_queue = spsc_queue<int, spsc_segment_capacity, reply_alloc>;
+
+static std::unique_ptr<reply_alloc> reply_allocator;
+static std::unique_ptr<reply_spsc_queue> spsc_reply;
+static std::unique_ptr<locked_queue> locked_reply;
+
+template <typename request_queue, typename reply_queue>
+static void round_trip(benchmark::State &state, request_queue &requests,
+                       reply_queue &replies) {
+  if (state.thread_index() == 0) {
+    int next = 0;
+    for (auto _ : state) {
+      requests.push(next);
+      result<int> reply = replies.pop();
+      while (!reply) { reply = replies.pop(); }
+      if (*reply != next++) { state.SkipWithError("reply out of order"); }
+    }
+  } else {
+    for (auto _ : state) {
+      result<int> request = requests.pop();
+      while (!request) { request = requests.pop(); }
+      replies.push(*request);
+    }
+  }
+}
+
+static void create_spsc_pair(const benchmark::State &state) {
+  create_spsc(state);
+  reply_allocator = std::make_unique<reply_alloc>();
+  spsc_reply = std::make_unique<reply_spsc_queue>(reply_allocator.get());
+}
+
+static void destroy_spsc_pair(const benchmark::State &state) {
+  destroy_spsc(state);
+  spsc_reply.reset();
+  reply_allocator.reset();
+}
+
+static void create_locked_pair(const benchmark::State &state) {
+  create_locked(state);
+  locked_reply = std::make_unique<locked_queue>();
+}
+
+static void destroy_locked_pair(const benchmark::State &state) {
+  destroy_locked(state);
+  locked_reply.reset();
+}
+
+static void BM_SpscRoundTrip(benchmark::State &state) {
+  round_trip(state, *spsc, *spsc_reply);
+}
+BENCHMARK(BM_SpscRoundTrip)
+    ->Setup(create_spsc_pair)
+    ->Teardown(destroy_spsc_pair)
+    ->Threads(2)
+    ->UseRealTime();
+
+static void BM_LockedQueueRoundTrip(benchmark::State &state) {
+  round_trip(state, *locked, *locked_reply);
+}
+BENCHMARK(BM_LockedQueueRoundTrip)
+    ->Setup(create_locked_pair)
+    ->Teardown(destroy_locked_pair)
+    ->Threads(2)
+    ->UseRealTime();
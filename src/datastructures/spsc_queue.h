@@ -0,0 +1,234 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <event_count.h>
+#include <result/result.h>
+#include <types.h>
+
+template <typename allocator_type> struct spsc_queue_allocator_storage {
+  inline static allocator_type *_allocator{nullptr};
+};
+
+// Lock-free single-producer/single-consumer FIFO queue implemented as a linked
+// list of fixed-size segments.
+//
+// Positions are free-running element counts: the producer publishes _tail
+// with release after constructing an element, the consumer publishes _head
+// with release after destroying one. Each side keeps a cached copy of the
+// opposite index and only reloads it (acquire) when the cache says the queue
+// is empty (consumer) or a segment may be reclaimable (producer).
+//
+// Only the producer calls into the allocator. A segment is handed back once
+// the consumer has moved past it, which the producer checks before linking a
+// new segment. The allocator must provide offset pointers (local_buffer), so
+// resolving a segment's next pointer never reads allocator state the producer
+// mutates, and must not be shared with any other thread.
+template <is_nothrow T, size_t segment_capacity,
+          contiguous_allocator allocator_type>
+class spsc_queue {
+public:
+  using storage = spsc_queue_allocator_storage<allocator_type>;
+
+  static constexpr size_t capacity_v = segment_capacity;
+  static constexpr size_t cache_line =
+      std::hardware_destructive_interference_size;
+
+  static_assert(segment_capacity > 0, "segment capacity must be > 0");
+
+private:
+  struct segment;
+  using segment_pointer =
+      typename allocator_type::pointer_type::template rebind<segment>;
+
+  struct segment {
+    segment_pointer next{nullptr};
+    alignas(T) std::byte slots[segment_capacity * sizeof(T)];
+
+    T *slot(size_t index) noexcept {
+      return std::launder(reinterpret_cast<T *>(slots + index * sizeof(T)));
+    }
+  };
+
+public:
+  static_assert(sizeof(segment) <= allocator_type::block_size,
+                "allocator block_size too small for segment");
+  static_assert(allocator_type::block_size % alignof(segment) == 0,
+                "allocator block_size must be a multiple of segment alignment");
+
+private:
+  // Producer
+  alignas(cache_line) std::atomic<size_t> _tail{0};
+  size_t _cached_head{0};
+  segment *_write_segment{nullptr};
+  size_t _write_offset{0};
+  segment *_oldest{nullptr}; // oldest segment not yet handed back
+  size_t _oldest_end{segment_capacity}; // position one past its last slot
+
+  // Consumer
+  alignas(cache_line) std::atomic<size_t> _head{0};
+  size_t _cached_tail{0};
+  segment *_read_segment{nullptr};
+  size_t _read_offset{0};
+
+  // Sleeping consumer, read by the producer after every push
+  alignas(cache_line) event_count _available;
+
+public:
+  explicit spsc_queue(allocator_type *allocator) {
+    fatal(allocator == nullptr, "Allocator cannot be null");
+    storage::_allocator = allocator;
+
+    auto first = allocate_segment();
+    fatal(!first, "Failed to allocate spsc_queue segment");
+    _write_segment = _oldest = _read_segment = *first;
+  }
+
+  // Neither side may be running
+  ~spsc_queue() {
+    while (pop()) {}
+
+    while (_oldest != nullptr) {
+      segment *next = _oldest->next;
+      deallocate_segment(_oldest);
+      _oldest = next;
+    }
+  }
+
+  spsc_queue(const spsc_queue &) = delete;
+  spsc_queue &operator=(const spsc_queue &) = delete;
+  spsc_queue(spsc_queue &&) = delete;
+  spsc_queue &operator=(spsc_queue &&) = delete;
+
+  // Producer only
+  template <typename U>
+    requires std::constructible_from<T, U>
+  result<> push(U &&value) noexcept {
+    return emplace(std::forward<U>(value));
+  }
+
+  // Producer only
+  template <typename... Args>
+    requires std::constructible_from<T, Args...>
+  result<> emplace(Args &&...args) noexcept {
+    if (_write_offset == segment_capacity) { ok(append_segment()); }
+
+    new (_write_segment->slot(_write_offset)) T(std::forward<Args>(args)...);
+    ++_write_offset;
+    _tail.store(_tail.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+    _available.notify_one();
+    return {};
+  }
+
+  // Consumer only. Failing on an empty queue is expected while polling, so
+  // it is not logged.
+  result<T> pop() noexcept {
+    size_t head = _head.load(std::memory_order_relaxed);
+    if (head == _cached_tail) {
+      _cached_tail = _tail.load(std::memory_order_acquire);
+      fail(head == _cached_tail, "Cannot pop from empty spsc_queue").silent();
+    }
+
+    // The producer linked the next segment before publishing this element
+    if (_read_offset == segment_capacity) {
+      _read_segment = _read_segment->next;
+      _read_offset = 0;
+    }
+
+    T *ptr = _read_segment->slot(_read_offset);
+    T value = std::move(*ptr);
+    ptr->~T();
+    ++_read_offset;
+    _head.store(head + 1, std::memory_order_release);
+    return value;
+  }
+
+  // Consumer only. Sleeps while the queue is empty instead of polling.
+  T pop_wait() noexcept {
+    while (true) {
+      if (auto value = pop()) { return std::move(*value); }
+
+      uint32_t key = _available.prepare_wait();
+      if (auto value = pop()) {
+        _available.cancel_wait();
+        return std::move(*value);
+      }
+      _available.wait(key);
+    }
+  }
+
+  // Consumer only
+  template <typename rep, typename period>
+  result<T> pop_wait_for(std::chrono::duration<rep, period> timeout) noexcept {
+    auto deadline =
+        std::chrono::steady_clock::now() +
+        std::chrono::ceil<std::chrono::steady_clock::duration>(timeout);
+
+    while (true) {
+      if (auto value = pop()) { return value; }
+
+      uint32_t key = _available.prepare_wait();
+      if (auto value = pop()) {
+        _available.cancel_wait();
+        return value;
+      }
+      fail(!_available.wait_until(key, deadline),
+           "Timed out waiting on empty spsc_queue")
+          .silent();
+    }
+  }
+
+  // Consumer only
+  bool empty() const noexcept {
+    return _head.load(std::memory_order_relaxed) ==
+           _tail.load(std::memory_order_acquire);
+  }
+
+  // Snapshot, exact only while neither side is running
+  size_t size() const noexcept {
+    size_t head = _head.load(std::memory_order_acquire);
+    return _tail.load(std::memory_order_acquire) - head;
+  }
+
+private:
+  static result<segment *> allocate_segment() noexcept {
+    auto block = ok(storage::_allocator->allocate_block());
+    return new (static_cast<void *>(block)) segment{};
+  }
+
+  static void deallocate_segment(segment *seg) noexcept {
+    seg->~segment();
+    typename allocator_type::pointer_type block(static_cast<void *>(seg));
+    storage::_allocator->deallocate_block(block);
+  }
+
+  // Hand back every segment the consumer has moved past. The consumer reads a
+  // segment's next pointer when popping the first element after it, so a
+  // segment is done once _head is beyond its end.
+  void reclaim_segments() noexcept {
+    if (_cached_head <= _oldest_end) {
+      _cached_head = _head.load(std::memory_order_acquire);
+    }
+
+    while (_oldest != _write_segment && _cached_head > _oldest_end) {
+      segment *next = _oldest->next;
+      deallocate_segment(_oldest);
+      _oldest = next;
+      _oldest_end += segment_capacity;
+    }
+  }
+
+  result<> append_segment() noexcept {
+    reclaim_segments();
+
+    segment *seg = ok(allocate_segment());
+    _write_segment->next = segment_pointer(seg);
+    _write_segment = seg;
+    _write_offset = 0;
+    return {};
+  }
+};
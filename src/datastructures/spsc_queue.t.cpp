@@ -0,0 +1,130 @@
+#include <chrono>
+#include <gtest/gtest.h>
+#include <local_buffer.h>
+#include <spsc_queue.h>
+#include <memory>
+#include <thread>
+
+constexpr int segment_capacity = 8;
+
+// 8 segments in total, so anything beyond that relies on reclamation
+using local_alloc = local_buffer(64, 8);
+using test_queue = spsc_queue<int, segment_capacity, local_alloc>;
+
+class SpscQueueTest : public ::testing::Test {
+protected:
+  local_alloc allocator;
+  test_queue q{&allocator};
+};
+
+// ============================================================================
+// Single-Threaded Behavior
+// ============================================================================
+
+TEST_F(SpscQueueTest, InitiallyEmpty) {
+  EXPECT_TRUE(q.empty());
+  EXPECT_EQ(q.size(), 0);
+  EXPECT_FALSE(q.pop().has_value());
+}
+
+TEST_F(SpscQueueTest, MaintainsFIFOOrderAcrossSegments) {
+  for (int i = 0; i < segment_capacity * 3 + 1; ++i) {
+    ASSERT_TRUE(q.push(i).has_value());
+  }
+  EXPECT_EQ(q.size(), segment_capacity * 3 + 1);
+
+  for (int i = 0; i < segment_capacity * 3 + 1; ++i) {
+    EXPECT_EQ(*q.pop(), i);
+  }
+  EXPECT_TRUE(q.empty());
+}
+
+TEST_F(SpscQueueTest, EmplaceConstructsInPlace) {
+  ASSERT_TRUE(q.emplace(42).has_value());
+  EXPECT_EQ(*q.pop(), 42);
+}
+
+TEST_F(SpscQueueTest, ReclaimsConsumedSegments) {
+  // Far more segments than the allocator holds pass through the queue
+  for (int cycle = 0; cycle < 100; ++cycle) {
+    for (int i = 0; i < segment_capacity * 4; ++i) {
+      ASSERT_TRUE(q.push(cycle * 1000 + i).has_value())
+          << "segments not reclaimed in cycle " << cycle;
+    }
+    for (int i = 0; i < segment_capacity * 4; ++i) {
+      EXPECT_EQ(*q.pop(), cycle * 1000 + i);
+    }
+  }
+}
+
+TEST_F(SpscQueueTest, PopWaitForTimesOutOnEmptyQueue) {
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(q.pop_wait_for(std::chrono::milliseconds(20)).has_value());
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(20));
+}
+
+TEST_F(SpscQueueTest, PopWaitReturnsAvailableElement) {
+  ASSERT_TRUE(q.push(7).has_value());
+  EXPECT_EQ(q.pop_wait(), 7);
+  ASSERT_TRUE(q.push(8).has_value());
+  EXPECT_EQ(*q.pop_wait_for(std::chrono::seconds(1)), 8);
+}
+
+// ============================================================================
+// Producer/Consumer Threads
+// ============================================================================
+
+TEST(SpscQueueThreadTest, TransfersInOrderAcrossThreads) {
+  using thread_alloc = local_buffer(256, 64);
+  using thread_queue = spsc_queue<int, 60, thread_alloc>;
+
+  constexpr int count = 200000;
+  // Keep the producer well within the allocator's 64 segments
+  constexpr size_t max_in_flight = 60 * 32;
+  auto allocator = std::make_unique<thread_alloc>();
+  thread_queue q{allocator.get()};
+
+  std::thread producer([&q] {
+    for (int i = 0; i < count; ++i) {
+      while (q.size() >= max_in_flight) {
+        std::this_thread::yield();
+      }
+      ASSERT_TRUE(q.push(i).has_value());
+    }
+  });
+
+  for (int expected = 0; expected < count;) {
+    auto value = q.pop();
+    if (!value) { continue; }
+    ASSERT_EQ(*value, expected);
+    ++expected;
+  }
+
+  producer.join();
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(SpscQueueThreadTest, PopWaitWakesOnPush) {
+  using wait_alloc = local_buffer(256, 8);
+  using wait_queue = spsc_queue<int, 60, wait_alloc>;
+
+  constexpr int count = 1000;
+  auto allocator = std::make_unique<wait_alloc>();
+  wait_queue q{allocator.get()};
+
+  // Pauses make the consumer go to sleep on an empty queue repeatedly
+  std::thread producer([&q] {
+    for (int i = 0; i < count; ++i) {
+      if (i % 100 == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      ASSERT_TRUE(q.push(i).has_value());
+    }
+  });
+
+  for (int expected = 0; expected < count; ++expected) {
+    ASSERT_EQ(q.pop_wait(), expected);
+  }
+  producer.join();
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <queue.h>
+#include <result/result.h>
+
+// FIFO queue over two size classes of ring_buffers, each tier a queue with
+// its own allocators.
+//
+// Pushes go to the small tier until it holds promote_after full ring_buffers,
+// then to the large tier until the large tier drains again. Every element in
+// the small tier is therefore older than every element in the large tier, and
+// pops drain the small tier first. Shallow queues only ever touch the small
+// ring_buffers, deep ones are chained from few large ones. large_queue_type
+// may itself be a tiered_queue to add further size classes.
+template <typename small_queue_type, typename large_queue_type,
+          size_t promote_after = 4>
+  requires std::same_as<typename small_queue_type::value_type,
+                        typename large_queue_type::value_type>
+class tiered_queue {
+public:
+  using value_type = typename small_queue_type::value_type;
+
+  // Elements the small tier holds before pushes move to the large tier
+  static constexpr size_t promote_at_v =
+      promote_after * small_queue_type::ring_buffer_type::capacity_v;
+
+  static_assert(promote_after > 0, "promote_after must be > 0");
+
+private:
+  small_queue_type _small;
+  large_queue_type _large;
+
+  // O(promote_after) unless the small tier counts its size
+  bool pushes_to_large() const noexcept {
+    return !_large.empty() || _small.size() >= promote_at_v;
+  }
+
+public:
+  // The small tier's local and list allocators, followed by whatever the
+  // large tier's constructor takes
+  tiered_queue(auto *small_local_alloc, auto *small_list_alloc,
+               auto *...large_allocs)
+      : _small(small_local_alloc, small_list_alloc), _large(large_allocs...) {}
+
+  tiered_queue(const tiered_queue &) = delete;
+  tiered_queue &operator=(const tiered_queue &) = delete;
+  tiered_queue(tiered_queue &&) noexcept = default;
+  tiered_queue &operator=(tiered_queue &&) noexcept = default;
+
+  void swap(tiered_queue &other) noexcept {
+    _small.swap(other._small);
+    _large.swap(other._large);
+  }
+
+  template <typename U>
+    requires std::constructible_from<value_type, U>
+  result<> push(U &&value) noexcept {
+    if (pushes_to_large()) { return _large.push(std::forward<U>(value)); }
+    return _small.push(std::forward<U>(value));
+  }
+
+  template <typename... Args>
+    requires std::constructible_from<value_type, Args...>
+  result<> emplace(Args &&...args) noexcept {
+    if (pushes_to_large()) {
+      return _large.emplace(std::forward<Args>(args)...);
+    }
+    return _small.emplace(std::forward<Args>(args)...);
+  }
+
+  result<value_type> pop() noexcept {
+    if (!_small.empty()) { return _small.pop(); }
+    return _large.pop();
+  }
+
+  // Fills the small tier up to promote_at_v, the rest goes to the large tier
+  result<> push_range(std::span<const value_type> values) noexcept
+    requires std::copy_constructible<value_type>
+  {
+    if (!pushes_to_large()) {
+      auto room = std::min(values.size(), promote_at_v - _small.size());
+      ok(_small.push_range(values.first(room)));
+      values = values.subspan(room);
+    }
+    if (values.empty()) { return {}; }
+    return _large.push_range(values);
+  }
+
+  result<size_t> pop_n(std::span<value_type> out) noexcept {
+    size_t popped = ok(_small.pop_n(out));
+    return popped + ok(_large.pop_n(out.subspan(popped)));
+  }
+
+  // Oldest contiguous chunk of readable data, without copying it out
+  result<std::span<const value_type>> peek() const noexcept {
+    if (!_small.empty()) { return _small.peek(); }
+    return _large.peek();
+  }
+
+  result<const value_type *> front() const noexcept {
+    if (!_small.empty()) { return _small.front(); }
+    return _large.front();
+  }
+
+  result<const value_type *> back() const noexcept {
+    if (!_large.empty()) { return _large.back(); }
+    return _small.back();
+  }
+
+  void clear() noexcept {
+    _small.clear();
+    _large.clear();
+  }
+
+  bool empty() const noexcept { return _small.empty() && _large.empty(); }
+  size_t size() const noexcept { return _small.size() + _large.size(); }
+
+  const small_queue_type &small_tier() const noexcept { return _small; }
+  const large_queue_type &large_tier() const noexcept { return _large; }
+};
@@ -0,0 +1,169 @@
+#include "growing_pool.h"
+#include <allocators/test_allocator.h>
+#include <gtest/gtest.h>
+#include <local_buffer.h>
+#include <memory>
+#include <tiered_queue.h>
+#include <vector>
+
+constexpr size_t small_capacity = 4;
+constexpr size_t large_capacity = 16;
+constexpr size_t promote_after = 2;
+constexpr size_t promote_at = small_capacity * promote_after;
+
+using small_local_alloc = local_buffer(16, 128);
+using small_list_alloc = growing_pool(8, 32, small_local_alloc);
+using large_local_alloc = local_buffer(64, 32);
+
+using small_queue =
+    queue<int, small_capacity, small_local_alloc, small_list_alloc>;
+using large_queue =
+    queue<int, large_capacity, large_local_alloc, simple_test_allocator>;
+using test_queue = tiered_queue<small_queue, large_queue, promote_after>;
+
+static_assert(test_queue::promote_at_v == promote_at);
+
+class TieredQueueTest : public ::testing::Test {
+protected:
+  std::unique_ptr<small_local_alloc> small_local;
+  std::unique_ptr<small_list_alloc> small_list;
+  std::unique_ptr<large_local_alloc> large_local;
+  simple_test_allocator large_list;
+  std::unique_ptr<test_queue> q;
+
+  void SetUp() override {
+    small_local = std::make_unique<small_local_alloc>();
+    small_list = std::make_unique<small_list_alloc>(small_local.get());
+    large_local = std::make_unique<large_local_alloc>();
+    q = std::make_unique<test_queue>(small_local.get(), small_list.get(),
+                                     large_local.get(), &large_list);
+  }
+
+  void TearDown() override { q.reset(); }
+
+  void push_sequence(int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      ASSERT_TRUE(q->push(i).has_value());
+    }
+  }
+};
+
+TEST_F(TieredQueueTest, ShallowQueueStaysInSmallTier) {
+  push_sequence(0, promote_at);
+
+  EXPECT_EQ(q->small_tier().size(), promote_at);
+  EXPECT_TRUE(q->large_tier().empty());
+}
+
+TEST_F(TieredQueueTest, DeepQueueMovesToLargeTier) {
+  push_sequence(0, promote_at + large_capacity * 3);
+
+  EXPECT_EQ(q->small_tier().size(), promote_at);
+  EXPECT_EQ(q->large_tier().size(), large_capacity * 3);
+  EXPECT_EQ(q->size(), promote_at + large_capacity * 3);
+}
+
+TEST_F(TieredQueueTest, MaintainsFIFOOrderAcrossTiers) {
+  constexpr int count = promote_at + large_capacity * 3 + 1;
+  push_sequence(0, count);
+
+  for (int i = 0; i < count; ++i) {
+    EXPECT_EQ(*q->pop(), i);
+  }
+  EXPECT_TRUE(q->empty());
+}
+
+TEST_F(TieredQueueTest, PushesStayInLargeTierUntilItDrains) {
+  push_sequence(0, promote_at + 1);
+  for (int i = 0; i < static_cast<int>(promote_at); ++i) {
+    EXPECT_EQ(*q->pop(), i);
+  }
+
+  // The small tier is empty but older elements remain in the large tier
+  push_sequence(promote_at + 1, promote_at + 3);
+  EXPECT_TRUE(q->small_tier().empty());
+  for (int i = promote_at; i < static_cast<int>(promote_at) + 3; ++i) {
+    EXPECT_EQ(*q->pop(), i);
+  }
+
+  // Drained, so the next push starts over in the small tier
+  ASSERT_TRUE(q->push(99).has_value());
+  EXPECT_EQ(q->small_tier().size(), 1);
+  EXPECT_TRUE(q->large_tier().empty());
+}
+
+TEST_F(TieredQueueTest, EmplaceFollowsPushTier) {
+  for (int i = 0; i < static_cast<int>(promote_at) + 1; ++i) {
+    ASSERT_TRUE(q->emplace(i).has_value());
+  }
+  EXPECT_EQ(q->large_tier().size(), 1);
+  EXPECT_EQ(*q->back(), static_cast<int>(promote_at));
+}
+
+TEST_F(TieredQueueTest, PushRangeSplitsAcrossTiers) {
+  std::vector<int> values(promote_at + large_capacity + 3);
+  for (int i = 0; i < static_cast<int>(values.size()); ++i) {
+    values[i] = i;
+  }
+  ASSERT_TRUE(q->push_range(values).has_value());
+
+  EXPECT_EQ(q->small_tier().size(), promote_at);
+  EXPECT_EQ(q->large_tier().size(), large_capacity + 3);
+
+  std::vector<int> out(values.size());
+  EXPECT_EQ(*q->pop_n(out), values.size());
+  EXPECT_EQ(out, values);
+  EXPECT_TRUE(q->empty());
+}
+
+TEST_F(TieredQueueTest, FrontBackAndPeekSpanTiers) {
+  push_sequence(0, promote_at + 2);
+
+  EXPECT_EQ(*q->front(), 0);
+  EXPECT_EQ(*q->back(), static_cast<int>(promote_at) + 1);
+  EXPECT_EQ((*q->peek())[0], 0);
+
+  std::vector<int> out(promote_at);
+  ASSERT_EQ(*q->pop_n(out), promote_at);
+  EXPECT_EQ(*q->front(), static_cast<int>(promote_at));
+  EXPECT_EQ((*q->peek())[0], static_cast<int>(promote_at));
+}
+
+TEST_F(TieredQueueTest, ClearEmptiesBothTiers) {
+  push_sequence(0, promote_at + large_capacity);
+  q->clear();
+
+  EXPECT_TRUE(q->empty());
+  EXPECT_EQ(q->size(), 0);
+  ASSERT_TRUE(q->push(1).has_value());
+  EXPECT_EQ(q->small_tier().size(), 1);
+}
+
+TEST(TieredQueueNestingTest, ThreeSizeClassesKeepFIFOOrder) {
+  using huge_local_alloc = local_buffer(256, 8);
+  using huge_queue = queue<int, 64, huge_local_alloc, simple_test_allocator>;
+  using upper_tiers = tiered_queue<large_queue, huge_queue, 1>;
+  using nested_queue = tiered_queue<small_queue, upper_tiers, 1>;
+
+  auto small_local = std::make_unique<small_local_alloc>();
+  auto small_list = std::make_unique<small_list_alloc>(small_local.get());
+  auto large_local = std::make_unique<large_local_alloc>();
+  auto huge_local = std::make_unique<huge_local_alloc>();
+  simple_test_allocator list_alloc;
+
+  nested_queue q(small_local.get(), small_list.get(), large_local.get(),
+                 &list_alloc, huge_local.get(), &list_alloc);
+
+  constexpr int count = small_capacity + large_capacity + 64 * 3;
+  for (int i = 0; i < count; ++i) {
+    ASSERT_TRUE(q.push(i).has_value());
+  }
+  EXPECT_EQ(q.small_tier().size(), small_capacity);
+  EXPECT_EQ(q.large_tier().small_tier().size(), large_capacity);
+  EXPECT_EQ(q.large_tier().large_tier().size(), 64 * 3);
+
+  for (int i = 0; i < count; ++i) {
+    EXPECT_EQ(*q.pop(), i);
+  }
+  EXPECT_TRUE(q.empty());
+}
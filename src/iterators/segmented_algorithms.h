@@ -0,0 +1,124 @@
+#pragma once
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <utility>
+
+// ============================================================================
+// Segmented Algorithms
+// ============================================================================
+// A segmented iterator walks a sequence stored as contiguous chunks. Besides
+// the usual element-wise interface it exposes the chunk it is in (segment(),
+// an iterator dereferencing to a contiguous range) and its position inside
+// that chunk (offset()), and can be rebuilt from the two.
+//
+// The algorithms below go chunk by chunk and hand each chunk to the standard
+// algorithm as a pair of raw pointers, so the inner loops are plain
+// contiguous loops the compiler can unroll and vectorize, with no per-element
+// segment check.
+// ============================================================================
+
+template <typename iterator>
+concept segmented_iterator = requires(const iterator &it) {
+  { *it.segment() } -> std::ranges::contiguous_range;
+  { it.offset() } -> std::convertible_to<size_t>;
+  { it == it } -> std::convertible_to<bool>;
+} && std::constructible_from<iterator,
+                             decltype(std::declval<iterator>().segment()),
+                             size_t>;
+
+template <typename range>
+concept segmented_range = requires(const range &r) {
+  { r.begin() } -> segmented_iterator;
+  { r.end() } -> std::same_as<decltype(r.begin())>;
+};
+
+namespace segmented {
+
+// Visits [first, last) as [begin, end) pointer pairs, one per chunk. visit
+// returns where it stopped; stopping short of end ends the walk and yields
+// the iterator at that position, otherwise last is returned.
+template <segmented_iterator iterator, typename visitor>
+iterator visit_chunks(iterator first, iterator last, visitor &&visit) {
+  auto segment = first.segment();
+  size_t from = first.offset();
+
+  while (true) {
+    bool is_last = segment == last.segment();
+    if (is_last && last.offset() <= from) { return last; }
+
+    auto chunk = *segment;
+    auto *begin = std::ranges::data(chunk);
+    size_t to = is_last ? last.offset() : std::ranges::size(chunk);
+    auto *stop = visit(begin + from, begin + to);
+    if (stop != begin + to) {
+      return iterator(segment, static_cast<size_t>(stop - begin));
+    }
+    if (is_last) { return last; }
+
+    ++segment;
+    from = 0;
+  }
+}
+
+template <segmented_iterator iterator, typename function>
+function for_each(iterator first, iterator last, function f) {
+  visit_chunks(first, last, [&](auto *begin, auto *end) {
+    std::for_each(begin, end, std::ref(f));
+    return end;
+  });
+  return f;
+}
+
+template <segmented_iterator iterator, typename value_type>
+iterator find(iterator first, iterator last, const value_type &value) {
+  return visit_chunks(first, last, [&](auto *begin, auto *end) {
+    return std::find(begin, end, value);
+  });
+}
+
+template <segmented_iterator iterator, typename value_type>
+size_t count(iterator first, iterator last, const value_type &value) {
+  size_t total = 0;
+  visit_chunks(first, last, [&](auto *begin, auto *end) {
+    total += static_cast<size_t>(std::count(begin, end, value));
+    return end;
+  });
+  return total;
+}
+
+// memmove per chunk for trivially copyable elements and pointer outputs
+template <segmented_iterator iterator, typename output_iterator>
+output_iterator copy(iterator first, iterator last, output_iterator out) {
+  visit_chunks(first, last, [&](auto *begin, auto *end) {
+    out = std::copy(begin, end, out);
+    return end;
+  });
+  return out;
+}
+
+// Whole-range forms
+template <segmented_range range, typename function>
+function for_each(const range &r, function f) {
+  return segmented::for_each(r.begin(), r.end(), std::move(f));
+}
+
+template <segmented_range range, typename value_type>
+auto find(const range &r, const value_type &value) {
+  return segmented::find(r.begin(), r.end(), value);
+}
+
+template <segmented_range range, typename value_type>
+size_t count(const range &r, const value_type &value) {
+  return segmented::count(r.begin(), r.end(), value);
+}
+
+template <segmented_range range, typename output_iterator>
+output_iterator copy(const range &r, output_iterator out) {
+  return segmented::copy(r.begin(), r.end(), out);
+}
+
+} // namespace segmented
@@ -1,5 +1,7 @@
 #pragma once
 #include <cstddef>
+#include <cstdint>
+#include <types.h>
 
 template <typename T, typename unique_tag, typename tag> struct cache {
   inline static T _value{};
@@ -9,6 +11,16 @@ template <typename T, typename unique_tag, typename tag> struct cache {
   static void reset() noexcept { _value = T{}; }
 };
 
+// Hints belong to the thread's own pool
+template <typename T, typename unique_tag, typename tag>
+struct cache<T, per_thread<unique_tag>, tag> {
+  inline static thread_local T _value{};
+
+  static T get() noexcept { return _value; }
+  static void set(T value) noexcept { _value = value; }
+  static void reset() noexcept { _value = T{}; }
+};
+
 template <typename unique_tag>
 using alloc_hint_cache = cache<uint8_t, unique_tag, decltype([] {})>;
 
@@ -1,61 +1,104 @@
 #pragma once
 #include "allocator_interface.h"
 #include "offset_arithmetic.h"
+#include <array>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
 #include <new>
 #include <result/result.h>
+#include <types.h>
+
+template <typename unique_tag> struct segmented_ptr_registry {
+  inline static allocator_interface *_interface{nullptr};
+};
+
+// One registered pool per thread
+template <typename tag> struct segmented_ptr_registry<per_thread<tag>> {
+  inline static thread_local allocator_interface *_interface{nullptr};
+};
+
+// Segment base addresses by packed (manager, segment) id. The registered pool
+// enters a segment's base whenever it hands out one of its blocks, so
+// pointers can resolve with one table load instead of the virtual, checked
+// allocator_interface path.
+template <typename unique_tag, size_t entries> struct segment_base_table {
+  inline static std::array<std::byte *, entries> _bases{};
+};
+
+template <typename tag, size_t entries>
+struct segment_base_table<per_thread<tag>, entries> {
+  inline static thread_local std::array<std::byte *, entries> _bases{};
+};
+
+// The registered pool's reverse map from upstream block index to packed
+// (manager, segment) key + 1, 0 for blocks that are no segment. Converts a
+// raw address to a segmented pointer without scanning managers and
+// segments. _keys stays null when the upstream cannot number its blocks.
+template <typename unique_tag, typename key_type> struct segment_key_table {
+  inline static std::byte *_upstream_base{nullptr};
+  inline static size_t _block_shift{0};
+  inline static size_t _block_count{0};
+  inline static const key_type *_keys{nullptr};
+};
+
+template <typename tag, typename key_type>
+struct segment_key_table<per_thread<tag>, key_type> {
+  inline static thread_local std::byte *_upstream_base{nullptr};
+  inline static thread_local size_t _block_shift{0};
+  inline static thread_local size_t _block_count{0};
+  inline static thread_local const key_type *_keys{nullptr};
+};
 
 // Type-erased static storage for growing_pool pointer resolution.
 template <typename unique_tag> struct segmented_ptr_storage {
-  inline static allocator_interface *_interface{nullptr};
+  using registry = segmented_ptr_registry<unique_tag>;
 
   template <typename pool_type>
     requires std::derived_from<pool_type, allocator_interface>
   static result<> register_pool(pool_type *pool) noexcept {
     fail(pool == nullptr, "pool cannot be null");
-    fail(_interface != nullptr, "pool already registered");
-    _interface = static_cast<allocator_interface *>(pool);
+    fail(registry::_interface != nullptr, "pool already registered");
+    registry::_interface = static_cast<allocator_interface *>(pool);
     return {};
   }
 
-  static void unregister_pool() noexcept { _interface = nullptr; }
+  static void unregister_pool() noexcept { registry::_interface = nullptr; }
 
   template <typename manager_type>
   static result<manager_type *> get_manager(size_t manager_id) noexcept {
-    fail(_interface == nullptr, "pool not registered");
+    fail(registry::_interface == nullptr, "pool not registered");
 
-    void *manager_ptr = ok(_interface->get_manager(manager_id));
+    void *manager_ptr = ok(registry::_interface->get_manager(manager_id));
     return static_cast<manager_type *>(manager_ptr);
   }
 
   static result<size_t> find_manager_for_pointer(std::byte *ptr) noexcept {
-    fail(_interface == nullptr, "pool not registered");
-    return ok(_interface->find_manager_for_pointer(ptr));
+    fail(registry::_interface == nullptr, "pool not registered");
+    return ok(registry::_interface->find_manager_for_pointer(ptr));
   }
 
   template <typename T, typename block_t>
   static result<T *> resolve_pointer(size_t manager_id, size_t segment_id,
                                      size_t offset) noexcept {
-    fail(_interface == nullptr, "pool not registered");
+    fail(registry::_interface == nullptr, "pool not registered");
     std::byte *segment_base =
-        ok(_interface->get_segment_base(manager_id, segment_id));
+        ok(registry::_interface->get_segment_base(manager_id, segment_id));
     return offset_arithmetic<T, block_t>::resolve(segment_base, offset);
   }
 
   static result<size_t> find_segment_in_manager(size_t manager_id,
                                                 std::byte *ptr) noexcept {
-    fail(_interface == nullptr, "pool not registered");
-    return ok(_interface->find_segment_in_manager(manager_id, ptr));
+    fail(registry::_interface == nullptr, "pool not registered");
+    return ok(registry::_interface->find_segment_in_manager(manager_id, ptr));
   }
 
   static result<size_t> compute_offset_in_segment(size_t manager_id,
                                                   size_t segment_id,
                                                   std::byte *ptr,
                                                   size_t elem_size) noexcept {
-    fail(_interface == nullptr, "pool not registered");
-    return ok(_interface->compute_offset_in_segment(manager_id, segment_id, ptr,
-                                                    elem_size));
+    fail(registry::_interface == nullptr, "pool not registered");
+    return ok(registry::_interface->compute_offset_in_segment(
+        manager_id, segment_id, ptr, elem_size));
   }
 };
@@ -36,6 +36,22 @@ public:
 
   using id_storage_type = smallest_t<total_bits>;
 
+  // Packed (manager, segment) id + 1, as kept in the pool's reverse map
+  using segment_key_type =
+      smallest_t<(1ULL << (manager_bits + segment_bits)) + 1>;
+
+private:
+  using base_table =
+      segment_base_table<unique_tag, (1ULL << (manager_bits + segment_bits))>;
+  using key_table = segment_key_table<unique_tag, segment_key_type>;
+
+  static constexpr size_t table_index(size_t manager_id,
+                                      size_t segment_id) noexcept {
+    return (manager_id << segment_bits) | segment_id;
+  }
+
+public:
+
   static_assert(total_bits <= 64, "Total bits exceeds 64-bit storage");
   static_assert(offset_bits > 0, "offset_bits must be more than 0");
   static_assert(segment_bits > 0, "segment_bits must be more than 0");
@@ -52,13 +68,19 @@ public:
   friend class basic_segmented_ptr;
   friend class pointer_operations<T>;
 
+  // Release builds resolve through the segment base table, debug builds
+  // through the pool's checked path
   T *resolve_impl() const {
     if (is_null_impl()) { return nullptr; }
 
+#ifdef NDEBUG
+    return resolve_unchecked();
+#else
     size_t manager_id = get_manager_id();
     size_t segment_id = get_segment_id();
     size_t offset = get_offset();
     return resolve_via_storage(manager_id, segment_id, offset);
+#endif
   }
 
   void advance_impl(std::ptrdiff_t elements) {
@@ -125,6 +147,27 @@ public:
         reinterpret_cast<T *>(segment_base + (offset * sizeof(block_t))));
   }
 
+  // O(1) conversion through the pool's reverse map: the upstream block
+  // holding ptr is a segment, and its key names the manager and segment
+  static basic_segmented_ptr locate(std::byte *ptr) noexcept {
+    auto address = reinterpret_cast<std::uintptr_t>(ptr);
+    auto base = reinterpret_cast<std::uintptr_t>(key_table::_upstream_base);
+    if (address < base) { return nullptr; }
+
+    size_t block = (address - base) >> key_table::_block_shift;
+    if (block >= key_table::_block_count || key_table::_keys[block] == 0) {
+      return nullptr;
+    }
+
+    size_t byte_offset = (address - base) - (block << key_table::_block_shift);
+    if (byte_offset % sizeof(block_t) != 0) { return nullptr; }
+
+    size_t index = key_table::_keys[block] - 1;
+    return basic_segmented_ptr(index >> segment_bits,
+                               index & max_segment_index,
+                               byte_offset / sizeof(block_t));
+  }
+
   T *resolve_via_storage(size_t manager_id, size_t segment_id,
                          size_t offset) const {
     auto resolve_result = storage::template resolve_pointer<T, block_t>(
@@ -157,6 +200,11 @@ public:
       return;
     }
 
+    if (key_table::_keys != nullptr) {
+      *this = locate(static_cast<std::byte *>(ptr));
+      return;
+    }
+
     // Find which manager owns this pointer
     auto manager_id_result =
         storage::find_manager_for_pointer(static_cast<std::byte *>(ptr));
@@ -228,6 +276,43 @@ public:
     return basic_segmented_ptr(std::addressof(r));
   }
 
+  // Table load, shift and add; no virtual call, no result<>. Only valid for
+  // non-null pointers into segments the registered pool handed blocks out
+  // of.
+  T *resolve_unchecked() const noexcept {
+    std::byte *segment_base =
+        base_table::_bases[table_index(_id.manager, _id.segment)];
+    return offset_arithmetic<T, block_t>::resolve(segment_base, _id.offset);
+  }
+
+  // Called by the pool when it hands out blocks of a segment, or takes over
+  // managers from a checkpoint
+  static void set_segment_base(size_t manager_id, size_t segment_id,
+                               std::byte *segment_base) noexcept {
+    base_table::_bases[table_index(manager_id, segment_id)] = segment_base;
+  }
+
+  static void clear_segment_bases() noexcept {
+    base_table::_bases.fill(nullptr);
+  }
+
+  static constexpr segment_key_type segment_key(size_t manager_id,
+                                                size_t segment_id) noexcept {
+    return static_cast<segment_key_type>(table_index(manager_id, segment_id) +
+                                         1);
+  }
+
+  // Called by the pool with its reverse map over the upstream's blocks;
+  // keys == nullptr goes back to scanning the managers
+  static void attach_segment_keys(std::byte *upstream_base, size_t block_shift,
+                                  size_t block_count,
+                                  const segment_key_type *keys) noexcept {
+    key_table::_upstream_base = upstream_base;
+    key_table::_block_shift = block_shift;
+    key_table::_block_count = block_count;
+    key_table::_keys = keys;
+  }
+
   static constexpr size_t storage_bits() { return total_bits; }
   static constexpr size_t storage_bytes() { return sizeof(id_storage_type); }
 };
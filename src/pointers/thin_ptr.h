@@ -16,6 +16,12 @@ template <typename unique_tag, typename offset_type> struct thin_ptr_storage {
   inline static std::byte *_base = nullptr;
 };
 
+// One base per thread, each thread registers its own arena
+template <typename tag, typename offset_type>
+struct thin_ptr_storage<per_thread<tag>, offset_type> {
+  inline static thread_local std::byte *_base = nullptr;
+};
+
 // Offset-based pointer with configurable offset size.
 template <typename T, typename block_t, typename offset_type,
           typename unique_tag = void>
@@ -87,6 +93,13 @@ public:
   }
 
   offset_type offset() const noexcept { return _offset; }
+
+  // Inverse of offset(), for code that stores the raw offset elsewhere
+  static basic_thin_ptr from_offset(offset_type offset) noexcept {
+    basic_thin_ptr ptr;
+    ptr._offset = offset;
+    return ptr;
+  }
 };
 
 template <typename T, provides_offset allocator>
@@ -23,7 +23,9 @@
   X(buffer_not_registered, "buffer for this tag not registered")               \
   X(buffer_already_registered, "buffer already registered for this tag")       \
   /* Pointer ownership errors */                                               \
-  X(not_owned, "pointer not owned")
+  X(not_owned, "pointer not owned")                                            \
+  /* Flow control errors */                                                   \
+  X(backpressure, "queue limit reached")
 
 enum class error : std::uint8_t {
 #define X(name, str) name,